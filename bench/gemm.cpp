@@ -0,0 +1,120 @@
+/**
+ * Matrix multiply throughput: the old i-j-k loop through RowProxy against
+ * gemm() with scalar and avx2 micro-kernels, for sizes 8 .. 2048.
+ *
+ *   g++ -std=c++17 -O2 -I../lru gemm.cpp -o gemm && ./gemm [max_ref]
+ *
+ * the i-j-k loop is only timed up to max_ref (default 512), beyond that
+ * it takes minutes. the kernel columns run on one thread; the last table
+ * shows how 256 x 256 and 1024 x 1024 double products scale with
+ * gemm_parallel(). the smaller one fits in a single MC x NC block.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+#include "class-matrix.hpp"
+
+template <typename _Td>
+Matrix<_Td> mul_ijk(const Matrix<_Td> &a, const Matrix<_Td> &b)
+{
+    Matrix<_Td> c(a.RowSize(), b.ColSize(), 0);
+    for (size_t i = 0; i < a.RowSize(); ++i) {
+        for (size_t j = 0; j < b.ColSize(); ++j) {
+            for (size_t k = 0; k < a.ColSize(); ++k) {
+                c[i][j] += a[i][k] * b[k][j];
+            }
+        }
+    }
+    return c;
+}
+
+template <typename _Td>
+Matrix<_Td> random_matrix(size_t n, std::mt19937 &gen)
+{
+    Matrix<_Td> m(n, n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            m[i][j] = static_cast<_Td>(gen() % 19) - 9;
+        }
+    }
+    return m;
+}
+
+// GFLOP/s of f, repeated until at least 0.2s have passed
+template <typename F>
+double gflops(size_t n, F f)
+{
+    using clock = std::chrono::steady_clock;
+    size_t reps = 0;
+    auto start = clock::now();
+    double secs = 0;
+    do {
+        f();
+        ++reps;
+        secs = std::chrono::duration<double>(clock::now() - start).count();
+    } while (secs < 0.2);
+    return 2.0 * n * n * n * reps / secs / 1e9;
+}
+
+template <typename _Td>
+void run(const char *name, size_t max_ref)
+{
+    std::mt19937 gen(42);
+    std::printf("%-6s %6s %10s %10s %10s\n", name, "n", "ijk", "scalar", "avx2");
+    for (size_t n = 8; n <= 2048; n *= 2) {
+        Matrix<_Td> a = random_matrix<_Td>(n, gen), b = random_matrix<_Td>(n, gen);
+        volatile _Td sink = 0;
+        std::printf("%-6s %6zu ", "", n);
+        if (n <= max_ref)
+            std::printf("%10.2f ", gflops(n, [&] { sink = mul_ijk(a, b)[0][0]; }));
+        else
+            std::printf("%10s ", "-");
+        sjtu::set_gemm_dispatch(sjtu::gemm_isa::scalar);
+        std::printf("%10.2f ", gflops(n, [&] { sink = (a * b)[0][0]; }));
+        if (sjtu::set_gemm_dispatch(sjtu::gemm_isa::avx2)) {
+            std::printf("%10.2f\n", gflops(n, [&] { sink = (a * b)[0][0]; }));
+        } else {
+            std::printf("%10s\n", "-");
+        }
+        (void)sink;
+    }
+    sjtu::set_gemm_dispatch(sjtu::detect_gemm_isa());
+}
+
+void run_threads()
+{
+    std::mt19937 gen(42);
+    const size_t sizes[] = {256, 1024};
+    Matrix<double> a[2], b[2];
+    for (int i = 0; i < 2; ++i) {
+        a[i] = random_matrix<double>(sizes[i], gen);
+        b[i] = random_matrix<double>(sizes[i], gen);
+    }
+    size_t most = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("%-8s %10s %10s\n", "threads", "256", "1024");
+    for (size_t t = 1; t <= most; t *= 2) {
+        sjtu::gemm_parallel().threads = t;
+        volatile double sink = 0;
+        std::printf("%-8zu", t);
+        for (int i = 0; i < 2; ++i)
+            std::printf(" %10.2f", gflops(sizes[i], [&] { sink = (a[i] * b[i])[0][0]; }));
+        std::printf("\n");
+        (void)sink;
+    }
+    sjtu::gemm_parallel().threads = 1;
+}
+
+int main(int argc, char **argv)
+{
+    size_t max_ref = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 512;
+    sjtu::gemm_parallel().threads = 1;
+    run<int>("int", max_ref);
+    run<float>("float", max_ref);
+    run<double>("double", max_ref);
+    run_threads();
+    return 0;
+}
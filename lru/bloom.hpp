@@ -0,0 +1,95 @@
+#ifndef SJTU_BLOOM_HPP
+#define SJTU_BLOOM_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "utility.hpp"
+
+namespace sjtu {
+
+/**
+ * counting bloom filter over key hashes, so keys can be removed again.
+ *
+ * blocked layout: a key's PROBES counters all lie in one 64 byte block,
+ * so a lookup reads a single cache line. counters are 8 bit and stick
+ * at 255 once saturated (never decremented), which can only cost false
+ * positives. may_contain() never returns false for a key that was added
+ * and not removed.
+ *
+ * add / remove need external serialisation; may_contain may run
+ * concurrently with them and sees each counter either before or after
+ * an update.
+ */
+class counting_bloom {
+  static constexpr size_t BLOCK = 64;
+  static constexpr int PROBES = 6;
+  static constexpr uint8_t SATURATED = 255;
+
+  std::unique_ptr<std::atomic<uint8_t>[]> cells;
+  size_t blocks;
+
+  std::atomic<uint8_t> *block_of(uint64_t h) const {
+    return &cells[(h >> 32) % blocks * BLOCK];
+  }
+  // 第 i 个计数器在块内的位置，取自哈希的低 32 位
+  static size_t probe(uint64_t h, int i) {
+    return (h >> (i * 5)) % BLOCK;
+  }
+
+public:
+  /**
+   * sized for `expected` keys at bits_per_key counters each, rounded up
+   * to whole blocks. 8 counters per key give about 4% false positives
+   */
+  explicit counting_bloom(size_t expected, size_t bits_per_key = 8)
+      : blocks((expected * bits_per_key + BLOCK - 1) / BLOCK) {
+    if (blocks == 0)
+      blocks = 1;
+    cells.reset(new std::atomic<uint8_t>[blocks * BLOCK]());
+  }
+
+  void add(uint64_t key_hash) {
+    uint64_t h = mix_hash(key_hash);
+    std::atomic<uint8_t> *b = block_of(h);
+    for (int i = 0; i < PROBES; ++i) {
+      std::atomic<uint8_t> &c = b[probe(h, i)];
+      uint8_t v = c.load(std::memory_order_relaxed);
+      if (v != SATURATED)
+        c.store(v + 1, std::memory_order_relaxed);
+    }
+  }
+
+  // key_hash must have been added before
+  void remove(uint64_t key_hash) {
+    uint64_t h = mix_hash(key_hash);
+    std::atomic<uint8_t> *b = block_of(h);
+    for (int i = 0; i < PROBES; ++i) {
+      std::atomic<uint8_t> &c = b[probe(h, i)];
+      uint8_t v = c.load(std::memory_order_relaxed);
+      if (v != SATURATED && v != 0)
+        c.store(v - 1, std::memory_order_relaxed);
+    }
+  }
+
+  bool may_contain(uint64_t key_hash) const {
+    uint64_t h = mix_hash(key_hash);
+    const std::atomic<uint8_t> *b = block_of(h);
+    for (int i = 0; i < PROBES; ++i) {
+      if (b[probe(h, i)].load(std::memory_order_relaxed) == 0)
+        return false;
+    }
+    return true;
+  }
+
+  void clear() {
+    for (size_t i = 0; i < blocks * BLOCK; ++i)
+      cells[i].store(0, std::memory_order_relaxed);
+  }
+};
+
+} // namespace sjtu
+
+#endif
@@ -1,9 +1,12 @@
 #ifndef SJTU_INTEGER_HPP
 #define SJTU_INTEGER_HPP
 
+#include <atomic>
+
 class Integer {
 public:
-	static int counter;
+	// keys may be created and destroyed on different threads
+	static std::atomic<int> counter;
 	int val;
 	
 	Integer(int val) : val(val) {counter++;}
@@ -13,12 +16,13 @@ public:
 		val = rhs.val;
 		counter++;
 	}
+	Integer &operator=(const Integer &rhs) = default;
 
 	bool operator==(const Integer &rhs){
 		return val == rhs.val;
 	}
 };
 
-int Integer::counter = 0;
+std::atomic<int> Integer::counter(0);
 
 #endif
\ No newline at end of file
@@ -1,59 +1,328 @@
 #ifndef SJTU_MATRIX_HPP
 #define SJTU_MATRIX_HPP
 
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <iomanip>
+#include <locale>
+#include <new>
+#include <sstream>
+#include <string>
+#include <system_error>
 #include <vector>
 #include <stdexcept>
+#include <type_traits>
 
+#include "gemm.hpp"
+#include "utility.hpp"
+
+/**
+ * allocator handing out Align-byte aligned storage, so a matrix buffer
+ * starts on a cache line
+ */
+template<typename T, size_t Align = 64>
+struct aligned_allocator {
+    using value_type = T;
+    template<typename U> struct rebind {
+        using other = aligned_allocator<U, Align>;
+    };
+    aligned_allocator() = default;
+    template<typename U>
+    aligned_allocator(const aligned_allocator<U, Align> &) {}
+    T * allocate(size_t n)
+    {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Align)));
+    }
+    void deallocate(T *p, size_t)
+    {
+        ::operator delete(p, std::align_val_t(Align));
+    }
+    template<typename U>
+    bool operator==(const aligned_allocator<U, Align> &) const { return true; }
+    template<typename U>
+    bool operator!=(const aligned_allocator<U, Align> &) const { return false; }
+};
+
+template<typename _Td> class Matrix;
+template<typename _Td> class MatrixView;
+template<typename _Td> class ConstMatrixView;
+template<typename T> struct ExprTarget;
+
+/**
+ * base of everything that can stand for a matrix in an element-wise
+ * expression. E provides value_type, RowSize(), ColSize() and elem(i),
+ * the i-th element in row-major order. a + b - c * 2 builds a tree of
+ * such nodes and computes nothing until it is assigned to a Matrix,
+ * which then evaluates it in a single loop.
+ * matrices are referenced, not copied: do not keep an expression (e.g.
+ * with auto) beyond the statement its operands live in.
+ * E may also provide aliases(dst) (see ExprTarget); without it assigning
+ * the expression always goes through a temporary.
+ */
+template<typename E>
+struct MatrixExpr {
+    const E & self() const
+    {
+        return static_cast<const E &>(*this);
+    }
+    template<typename T>
+    bool aliases(const ExprTarget<T> &) const
+    {
+        return true;
+    }
+};
+
+/**
+ * the elements an assignment writes, element k of the target at
+ * ptr + (k / cols) * row_stride + (k % cols) * col_stride.
+ * writing them in order while reading an expression is only safe if
+ * every operand either lies elsewhere in memory or maps element k to the
+ * same address (as in a = a + b); a = a.transposed() + b is not.
+ */
+template<typename T>
+struct ExprTarget {
+    const T *ptr;
+    size_t rows;
+    size_t cols;
+    ptrdiff_t row_stride;
+    ptrdiff_t col_stride;
+
+    // whether an operand laid out like this could be overwritten before it is read
+    template<typename U>
+    bool clobbers(const U *p, size_t r, size_t c, ptrdiff_t rs, ptrdiff_t cs) const
+    {
+        if (rows == 0 || cols == 0 || r == 0 || c == 0) {
+            return false;
+        }
+        if (static_cast<const void *>(p) == static_cast<const void *>(ptr) && sizeof(U) == sizeof(T)
+            && (r == 1 || rs == row_stride) && (c == 1 || cs == col_stride)) {
+            return false;
+        }
+        uintptr_t lo = 0, hi = 0, plo = 0, phi = 0;
+        span(ptr, rows, cols, row_stride, col_stride, lo, hi);
+        span(p, r, c, rs, cs, plo, phi);
+        return plo < hi && lo < phi;
+    }
+
+    // [lo, hi) covers the bytes of every element
+    template<typename U>
+    static void span(const U *p, size_t r, size_t c, ptrdiff_t rs, ptrdiff_t cs, uintptr_t &lo, uintptr_t &hi)
+    {
+        ptrdiff_t a = (ptrdiff_t)(r - 1) * rs, b = (ptrdiff_t)(c - 1) * cs;
+        ptrdiff_t first = std::min<ptrdiff_t>(a, 0) + std::min<ptrdiff_t>(b, 0);
+        ptrdiff_t last = std::max<ptrdiff_t>(a, 0) + std::max<ptrdiff_t>(b, 0);
+        lo = reinterpret_cast<uintptr_t>(p) + first * (ptrdiff_t)sizeof(U);
+        hi = reinterpret_cast<uintptr_t>(p) + (last + 1) * (ptrdiff_t)sizeof(U);
+    }
+};
+
+// a scalar operand is accepted only if mixing it with _Td yields _Td, i.e. it never has to be truncated
+template<typename S, typename _Td, typename = void>
+struct ExprScalar : std::false_type {};
+template<typename S, typename _Td>
+struct ExprScalar<S, _Td, std::void_t<std::common_type_t<S, _Td>>>
+    : std::is_same<std::common_type_t<S, _Td>, _Td> {};
+
+// how an expression node holds an operand: matrices by reference
+template<typename E>
+struct ExprOperand {
+    using type = const E;
+};
 template<typename _Td>
-class Matrix {
+struct ExprOperand<Matrix<_Td>> {
+    using type = const Matrix<_Td> &;
+};
+
+template<typename L, typename R, typename Op>
+class MatrixBinaryExpr : public MatrixExpr<MatrixBinaryExpr<L, R, Op>> {
+    typename ExprOperand<L>::type lhs;
+    typename ExprOperand<R>::type rhs;
+public:
+    using value_type = typename L::value_type;
+    MatrixBinaryExpr(const L &_lhs, const R &_rhs) : lhs(_lhs), rhs(_rhs)
+    {
+        if (lhs.RowSize() != rhs.RowSize() || lhs.ColSize() != rhs.ColSize()) {
+            throw std::invalid_argument("different matrics\'s sizes");
+        }
+    }
+    size_t RowSize() const { return lhs.RowSize(); }
+    size_t ColSize() const { return lhs.ColSize(); }
+    value_type elem(size_t i) const
+    {
+        return Op::apply(lhs.elem(i), rhs.elem(i));
+    }
+    template<typename T>
+    bool aliases(const ExprTarget<T> &dst) const
+    {
+        return lhs.aliases(dst) || rhs.aliases(dst);
+    }
+};
+
+// an expression combined with one scalar (or nothing, for negation)
+template<typename E, typename S, typename Op>
+class MatrixScalarExpr : public MatrixExpr<MatrixScalarExpr<E, S, Op>> {
+    typename ExprOperand<E>::type expr;
+    S scalar;
+public:
+    using value_type = typename E::value_type;
+    MatrixScalarExpr(const E &_expr, const S &_scalar) : expr(_expr), scalar(_scalar) {}
+    size_t RowSize() const { return expr.RowSize(); }
+    size_t ColSize() const { return expr.ColSize(); }
+    value_type elem(size_t i) const
+    {
+        return Op::apply(expr.elem(i), scalar);
+    }
+    template<typename T>
+    bool aliases(const ExprTarget<T> &dst) const
+    {
+        return expr.aliases(dst);
+    }
+};
+
+struct ExprAdd {
+    template<typename A, typename B>
+    static auto apply(const A &a, const B &b) { return a + b; }
+};
+struct ExprSub {
+    template<typename A, typename B>
+    static auto apply(const A &a, const B &b) { return a - b; }
+};
+struct ExprMul {
+    template<typename A, typename B>
+    static auto apply(const A &a, const B &b) { return a * b; }
+};
+struct ExprDiv {
+    template<typename A, typename B>
+    static auto apply(const A &a, const B &b) { return a / b; }
+};
+struct ExprNeg {
+    template<typename A>
+    static auto apply(const A &a, int) { return -a; }
+};
+
+/**
+ * elements are stored in one aligned buffer in row-major order, row i
+ * starting at data() + i * ColSize(). copying a matrix is a single
+ * allocation.
+ */
+template<typename _Td>
+class Matrix : public MatrixExpr<Matrix<_Td>> {
 protected:
     size_t n_rows = 0;
     size_t n_cols = 0;
-    std::vector<std::vector<_Td>> data;
+    std::vector<_Td, aligned_allocator<_Td>> buf;
+    struct from_expr {};
+    template<typename E>
+    Matrix(from_expr, const E &e)
+        : n_rows(e.RowSize()), n_cols(e.ColSize()), buf(n_rows * n_cols)
+    {
+        for (size_t i = 0; i < buf.size(); ++i) {
+            buf[i] = e.elem(i);
+        }
+    }
     class RowProxy {
-        std::vector<_Td> &row;
+        _Td *row;
     public:
-        RowProxy(std::vector<_Td> & _row) : row(_row) {}
+        RowProxy(_Td *_row) : row(_row) {}
         _Td & operator[](const size_t &pos)
         {
             return row[pos];
         }
     };
     class ConstRowProxy {
-        const std::vector<_Td> &row;
+        const _Td *row;
     public:
-        ConstRowProxy(const std::vector<_Td> &_row) : row(_row) {}
+        ConstRowProxy(const _Td *_row) : row(_row) {}
         const _Td & operator[](const size_t &pos) const
         {
             return row[pos];
         }
     };
 public:
+    using value_type = _Td;
     Matrix() {};
     Matrix(const size_t &_n_rows, const size_t &_n_cols)
-        : n_rows(_n_rows), n_cols(_n_cols), data(std::vector<std::vector<_Td>>(n_rows, std::vector<_Td>(n_cols))) {}
+        : n_rows(_n_rows), n_cols(_n_cols), buf(n_rows * n_cols) {}
     Matrix(const size_t &_n_rows, const size_t &_n_cols, const _Td &fillValue)
-        : n_rows(_n_rows), n_cols(_n_cols), data(std::vector<std::vector<_Td>>(n_rows, std::vector<_Td>(n_cols, fillValue))) {}
+        : n_rows(_n_rows), n_cols(_n_cols), buf(n_rows * n_cols, fillValue) {}
     Matrix(const Matrix<_Td> &mat)
-        : n_rows(mat.n_rows), n_cols(mat.n_cols), data(mat.data) {}
+        : n_rows(mat.n_rows), n_cols(mat.n_cols), buf(mat.buf) {}
     Matrix(Matrix<_Td> &&mat) noexcept
-        : n_rows(mat.n_rows), n_cols(mat.n_cols), data(mat.data) {}
+        : n_rows(mat.n_rows), n_cols(mat.n_cols), buf(std::move(mat.buf))
+    {
+        mat.n_rows = mat.n_cols = 0;
+    }
     Matrix<_Td> & operator=(const Matrix<_Td> &rhs)
     {
         this->n_rows = rhs.n_rows;
         this->n_cols = rhs.n_cols;
-        this->data = rhs.data;
+        this->buf = rhs.buf;
         return *this;
     }
-    Matrix<_Td> & operator=(Matrix<_Td> &&rhs)
+    Matrix<_Td> & operator=(Matrix<_Td> &&rhs) noexcept
     {
-        this->n_rows = rhs.n_rows;
-        this->n_cols = rhs.n_cols;
-        this->data = rhs.data;
+        if (this != &rhs) {
+            this->n_rows = rhs.n_rows;
+            this->n_cols = rhs.n_cols;
+            this->buf = std::move(rhs.buf);
+            rhs.n_rows = rhs.n_cols = 0;
+        }
+        return *this;
+    }
+    // evaluate an element-wise expression in one pass. implicit only from
+    // the same element type: converting the elements has to be asked for
+    template<typename E, std::enable_if_t<std::is_same<typename E::value_type, _Td>::value, int> = 0>
+    Matrix(const MatrixExpr<E> &expr) : Matrix(from_expr(), expr.self()) {}
+    template<typename E, std::enable_if_t<!std::is_same<typename E::value_type, _Td>::value, int> = 0>
+    explicit Matrix(const MatrixExpr<E> &expr) : Matrix(from_expr(), expr.self()) {}
+    /**
+     * evaluated in place when every operand of expr is elsewhere in memory
+     * or reads element i where element i is written (a = a + b), through
+     * a temporary otherwise (a = a.transposed() + b, or a new shape)
+     */
+    template<typename E, typename = std::enable_if_t<std::is_same<typename E::value_type, _Td>::value>>
+    Matrix<_Td> & operator=(const MatrixExpr<E> &expr)
+    {
+        const E &e = expr.self();
+        if (e.RowSize() != n_rows || e.ColSize() != n_cols || e.aliases(target())) {
+            return *this = Matrix<_Td>(expr);
+        }
+        for (size_t i = 0; i < buf.size(); ++i) {
+            buf[i] = e.elem(i);
+        }
+        return *this;
+    }
+    template<typename E>
+    Matrix<_Td> & operator+=(const MatrixExpr<E> &expr)
+    {
+        return *this = MatrixBinaryExpr<Matrix<_Td>, E, ExprAdd>(*this, expr.self());
+    }
+    template<typename E>
+    Matrix<_Td> & operator-=(const MatrixExpr<E> &expr)
+    {
+        return *this = MatrixBinaryExpr<Matrix<_Td>, E, ExprSub>(*this, expr.self());
+    }
+    template<typename S, typename = std::enable_if_t<ExprScalar<S, _Td>::value>>
+    Matrix<_Td> & operator*=(const S &scalar)
+    {
+        for (size_t i = 0; i < buf.size(); ++i) {
+            buf[i] *= scalar;
+        }
         return *this;
     }
+    // matrix product needs every element of a row, so it goes through a temporary
+    Matrix<_Td> & operator*=(const Matrix<_Td> &rhs);
+    // reshape to _n_rows x _n_cols filled with fillValue, reusing the buffer
+    void assign(size_t _n_rows, size_t _n_cols, const _Td &fillValue)
+    {
+        n_rows = _n_rows;
+        n_cols = _n_cols;
+        buf.assign(n_rows * n_cols, fillValue);
+    }
     inline const size_t & RowSize() const
     {
         return n_rows;
@@ -62,48 +331,287 @@ public:
     {
         return n_cols;
     }
+    // the most elements a matrix can hold, and so the most rows or columns
+    static size_t MaxSize()
+    {
+        return std::vector<_Td, aligned_allocator<_Td>>().max_size();
+    }
     RowProxy operator[](const size_t &Kth)
     {
-        return RowProxy(this->data[Kth]);
+        return RowProxy(row_data(Kth));
     }
     const ConstRowProxy operator[](const size_t &Kth) const
     {
-        return ConstRowProxy(this->data[Kth]);
+        return ConstRowProxy(row_data(Kth));
+    }
+    // RowSize() * ColSize() elements, row-major
+    _Td * data()
+    {
+        return buf.data();
+    }
+    const _Td * data() const
+    {
+        return buf.data();
+    }
+    // the ColSize() contiguous elements of row Kth
+    _Td * row_data(const size_t &Kth)
+    {
+        return buf.data() + Kth * n_cols;
+    }
+    const _Td * row_data(const size_t &Kth) const
+    {
+        return buf.data() + Kth * n_cols;
+    }
+    /**
+     * views sharing this matrix's elements, see MatrixView. they are
+     * invalidated when the matrix is resized, assigned or destroyed
+     */
+    MatrixView<_Td> view();
+    ConstMatrixView<_Td> view() const;
+    MatrixView<_Td> block(size_t r, size_t c, size_t h, size_t w);
+    ConstMatrixView<_Td> block(size_t r, size_t c, size_t h, size_t w) const;
+    MatrixView<_Td> transposed();
+    ConstMatrixView<_Td> transposed() const;
+    MatrixView<_Td> row(size_t Kth);
+    ConstMatrixView<_Td> row(size_t Kth) const;
+    size_t size() const
+    {
+        return buf.size();
+    }
+    const _Td & elem(size_t i) const
+    {
+        return buf[i];
+    }
+    ExprTarget<_Td> target() const
+    {
+        return ExprTarget<_Td>{data(), n_rows, n_cols, (ptrdiff_t)n_cols, 1};
+    }
+    template<typename T>
+    bool aliases(const ExprTarget<T> &dst) const
+    {
+        return dst.clobbers(data(), n_rows, n_cols, n_cols, 1);
     }
     ~Matrix() = default;
 };
 
 /**
- * Sum of two matrics.
+ * non-owning window on a matrix: element (i, j) lives at
+ * data + i * RowStride() + j * ColStride(), so blocks, transposes and
+ * single rows are views of the same storage without copying.
+ * a view is a MatrixExpr and can be used wherever a matrix can be read.
+ * copying a view copies the window; assigning to a MatrixView writes
+ * through to the viewed elements, going through a temporary when the
+ * source overlaps them in another layout (b.view() = b.transposed()).
  */
+template<typename _Td, typename P>
+class BasicMatrixView {
+protected:
+    P *ptr = nullptr;
+    size_t n_rows = 0;
+    size_t n_cols = 0;
+    ptrdiff_t row_stride = 0;
+    ptrdiff_t col_stride = 1;
+
+    class StridedRowProxy {
+        P *row;
+        ptrdiff_t stride;
+    public:
+        StridedRowProxy(P *_row, ptrdiff_t _stride) : row(_row), stride(_stride) {}
+        P & operator[](const size_t &pos) const
+        {
+            return row[(ptrdiff_t)pos * stride];
+        }
+    };
+    void check(size_t r, size_t c, size_t h, size_t w) const
+    {
+        if (r + h > n_rows || c + w > n_cols) {
+            throw std::out_of_range("view out of range");
+        }
+    }
+public:
+    using value_type = _Td;
+    BasicMatrixView() = default;
+    BasicMatrixView(P *_ptr, size_t _n_rows, size_t _n_cols, ptrdiff_t _row_stride, ptrdiff_t _col_stride = 1)
+        : ptr(_ptr), n_rows(_n_rows), n_cols(_n_cols), row_stride(_row_stride), col_stride(_col_stride) {}
+
+    size_t RowSize() const { return n_rows; }
+    size_t ColSize() const { return n_cols; }
+    size_t size() const { return n_rows * n_cols; }
+    ptrdiff_t RowStride() const { return row_stride; }
+    ptrdiff_t ColStride() const { return col_stride; }
+    P * data() const { return ptr; }
+
+    StridedRowProxy operator[](const size_t &Kth) const
+    {
+        return StridedRowProxy(ptr + (ptrdiff_t)Kth * row_stride, col_stride);
+    }
+    // element i in row-major order of the view
+    const _Td & elem(size_t i) const
+    {
+        return ptr[(ptrdiff_t)(i / n_cols) * row_stride + (ptrdiff_t)(i % n_cols) * col_stride];
+    }
+    ExprTarget<_Td> target() const
+    {
+        return ExprTarget<_Td>{ptr, n_rows, n_cols, row_stride, col_stride};
+    }
+    template<typename T>
+    bool aliases(const ExprTarget<T> &dst) const
+    {
+        return dst.clobbers(ptr, n_rows, n_cols, row_stride, col_stride);
+    }
+};
+
 template<typename _Td>
-Matrix<_Td> operator+(const Matrix<_Td> &a, const Matrix<_Td> &b)
-{
-    if (a.RowSize() != b.RowSize() || a.ColSize() != b.ColSize()) {
-        throw std::invalid_argument("different matrics\'s sizes");
+class ConstMatrixView : public BasicMatrixView<_Td, const _Td>, public MatrixExpr<ConstMatrixView<_Td>> {
+    using base = BasicMatrixView<_Td, const _Td>;
+public:
+    using base::base;
+    using base::aliases;
+    ConstMatrixView(const Matrix<_Td> &mat) : base(mat.data(), mat.RowSize(), mat.ColSize(), mat.ColSize()) {}
+    ConstMatrixView(const MatrixView<_Td> &view)
+        : base(view.data(), view.RowSize(), view.ColSize(), view.RowStride(), view.ColStride()) {}
+
+    ConstMatrixView block(size_t r, size_t c, size_t h, size_t w) const
+    {
+        this->check(r, c, h, w);
+        return ConstMatrixView(this->ptr + (ptrdiff_t)r * this->row_stride + (ptrdiff_t)c * this->col_stride,
+                               h, w, this->row_stride, this->col_stride);
     }
-    Matrix<_Td> c(a.RowSize(), a.ColSize());
-    for (size_t i = 0; i < a.RowSize(); ++i) {
-        for (size_t j = 0; j < a.ColSize(); ++j) {
-            c[i][j] = a[i][j] + b[i][j];
-        }
+    ConstMatrixView transposed() const
+    {
+        return ConstMatrixView(this->ptr, this->n_cols, this->n_rows, this->col_stride, this->row_stride);
     }
-    return c;
-}
+    ConstMatrixView row(size_t Kth) const
+    {
+        return block(Kth, 0, 1, this->n_cols);
+    }
+};
 
 template<typename _Td>
-Matrix<_Td> operator-(const Matrix<_Td> &a, const Matrix<_Td> &b)
-{
-    if (a.RowSize() != b.RowSize() || a.ColSize() != b.ColSize()) {
-        throw std::invalid_argument("different matrics\'s sizes");
+class MatrixView : public BasicMatrixView<_Td, _Td>, public MatrixExpr<MatrixView<_Td>> {
+    using base = BasicMatrixView<_Td, _Td>;
+
+    template<typename E>
+    void check_size(const E &e) const
+    {
+        if (e.RowSize() != this->n_rows || e.ColSize() != this->n_cols) {
+            throw std::invalid_argument("different matrics\'s sizes");
+        }
     }
-    Matrix<_Td> c(a.RowSize(), a.ColSize());
-    for (size_t i = 0; i < a.RowSize(); ++i) {
-        for (size_t j = 0; j < a.ColSize(); ++j) {
-            c[i][j] = a[i][j] - b[i][j];
+public:
+    using base::base;
+    using base::aliases;
+    MatrixView(Matrix<_Td> &mat) : base(mat.data(), mat.RowSize(), mat.ColSize(), mat.ColSize()) {}
+    MatrixView(const MatrixView &) = default;
+
+    // write the elements of expr, of the same element type, into the viewed ones
+    template<typename E, typename = std::enable_if_t<std::is_same<typename E::value_type, _Td>::value>>
+    MatrixView & operator=(const MatrixExpr<E> &expr)
+    {
+        const E &e = expr.self();
+        check_size(e);
+        if (e.aliases(this->target())) {
+            return *this = Matrix<_Td>(expr);
         }
+        size_t k = 0;
+        for (size_t i = 0; i < this->n_rows; ++i) {
+            _Td *r = this->ptr + (ptrdiff_t)i * this->row_stride;
+            for (size_t j = 0; j < this->n_cols; ++j) {
+                r[(ptrdiff_t)j * this->col_stride] = e.elem(k++);
+            }
+        }
+        return *this;
     }
-    return c;
+    MatrixView & operator=(const MatrixView &rhs)
+    {
+        return *this = static_cast<const MatrixExpr<MatrixView> &>(rhs);
+    }
+    template<typename E>
+    MatrixView & operator+=(const MatrixExpr<E> &expr)
+    {
+        return *this = MatrixBinaryExpr<MatrixView, E, ExprAdd>(*this, expr.self());
+    }
+    template<typename E>
+    MatrixView & operator-=(const MatrixExpr<E> &expr)
+    {
+        return *this = MatrixBinaryExpr<MatrixView, E, ExprSub>(*this, expr.self());
+    }
+    template<typename S, typename = std::enable_if_t<ExprScalar<S, _Td>::value>>
+    MatrixView & operator*=(const S &scalar)
+    {
+        return *this = MatrixScalarExpr<MatrixView, _Td, ExprMul>(*this, scalar);
+    }
+
+    MatrixView block(size_t r, size_t c, size_t h, size_t w) const
+    {
+        this->check(r, c, h, w);
+        return MatrixView(this->ptr + (ptrdiff_t)r * this->row_stride + (ptrdiff_t)c * this->col_stride,
+                          h, w, this->row_stride, this->col_stride);
+    }
+    MatrixView transposed() const
+    {
+        return MatrixView(this->ptr, this->n_cols, this->n_rows, this->col_stride, this->row_stride);
+    }
+    MatrixView row(size_t Kth) const
+    {
+        return block(Kth, 0, 1, this->n_cols);
+    }
+};
+
+template<typename _Td>
+MatrixView<_Td> Matrix<_Td>::view()
+{
+    return MatrixView<_Td>(*this);
+}
+template<typename _Td>
+ConstMatrixView<_Td> Matrix<_Td>::view() const
+{
+    return ConstMatrixView<_Td>(*this);
+}
+template<typename _Td>
+MatrixView<_Td> Matrix<_Td>::block(size_t r, size_t c, size_t h, size_t w)
+{
+    return view().block(r, c, h, w);
+}
+template<typename _Td>
+ConstMatrixView<_Td> Matrix<_Td>::block(size_t r, size_t c, size_t h, size_t w) const
+{
+    return view().block(r, c, h, w);
+}
+template<typename _Td>
+MatrixView<_Td> Matrix<_Td>::transposed()
+{
+    return view().transposed();
+}
+template<typename _Td>
+ConstMatrixView<_Td> Matrix<_Td>::transposed() const
+{
+    return view().transposed();
+}
+template<typename _Td>
+MatrixView<_Td> Matrix<_Td>::row(size_t Kth)
+{
+    return view().row(Kth);
+}
+template<typename _Td>
+ConstMatrixView<_Td> Matrix<_Td>::row(size_t Kth) const
+{
+    return view().row(Kth);
+}
+
+/**
+ * Sum of two matrics.
+ */
+template<typename L, typename R>
+MatrixBinaryExpr<L, R, ExprAdd> operator+(const MatrixExpr<L> &a, const MatrixExpr<R> &b)
+{
+    return MatrixBinaryExpr<L, R, ExprAdd>(a.self(), b.self());
+}
+
+template<typename L, typename R>
+MatrixBinaryExpr<L, R, ExprSub> operator-(const MatrixExpr<L> &a, const MatrixExpr<R> &b)
+{
+    return MatrixBinaryExpr<L, R, ExprSub>(a.self(), b.self());
 }
 template<typename _Td>
 bool operator==(const Matrix<_Td> &a, const Matrix<_Td> &b)
@@ -111,95 +619,173 @@ bool operator==(const Matrix<_Td> &a, const Matrix<_Td> &b)
     if (a.RowSize() != b.RowSize() || a.ColSize() != b.ColSize()) {
         return false;
     }
-    for (size_t i = 0; i < a.RowSize(); ++i) {
-        for (size_t j = 0; j < a.ColSize(); ++j) {
-            if (a[i][j] != b[i][j])
-                return false;
-        }
+    const _Td *pa = a.data(), *pb = b.data();
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (pa[i] != pb[i])
+            return false;
     }
     return true;
 }
 
-template<typename _Td>
-Matrix<_Td> operator-(const Matrix<_Td> &mat)
+template<typename L, typename R>
+bool operator==(const MatrixExpr<L> &a, const MatrixExpr<R> &b)
 {
-    Matrix<_Td> result(mat.RowSize(), mat.ColSize());
-    for (size_t i = 0; i < mat.RowSize(); ++i) {
-        for (size_t j = 0; j < mat.ColSize(); ++j) {
-            result[i][j] = -mat[i][j];
-        }
+    const L &l = a.self();
+    const R &r = b.self();
+    if (l.RowSize() != r.RowSize() || l.ColSize() != r.ColSize()) {
+        return false;
+    }
+    for (size_t i = 0; i < l.RowSize() * l.ColSize(); ++i) {
+        if (l.elem(i) != r.elem(i))
+            return false;
     }
-    return result;
+    return true;
+}
+
+template<typename E>
+MatrixScalarExpr<E, int, ExprNeg> operator-(const MatrixExpr<E> &mat)
+{
+    return MatrixScalarExpr<E, int, ExprNeg>(mat.self(), 0);
 }
 
+// a temporary matrix is negated in place
 template<typename _Td>
 Matrix<_Td> operator-(Matrix<_Td> &&mat)
 {
-    for (size_t i = 0; i < mat.RowSize(); ++i) {
-        for (size_t j = 0; j < mat.ColSize(); ++j) {
-            mat[i][j] = -mat[i][j];
-        }
+    _Td *p = mat.data();
+    for (size_t i = 0; i < mat.size(); ++i) {
+        p[i] = -p[i];
     }
-    return mat;
+    return std::move(mat);
 }
 
 /**
- * Multiplication of two matrics.
+ * c = a * b, written into c's existing buffer when it is large enough.
+ * c must not be a or b
  */
 template<typename _Td>
-Matrix<_Td> operator*(const Matrix<_Td> &a, const Matrix<_Td> &b)
+void Multiply(Matrix<_Td> &c, const Matrix<_Td> &a, const Matrix<_Td> &b)
 {
     if (a.ColSize() != b.RowSize()) {
         throw std::invalid_argument("different matrics\'s sizes");
     }
-    Matrix<_Td> c(a.RowSize(), b.ColSize(), 0);
+    c.assign(a.RowSize(), b.ColSize(), 0);
+    if constexpr (std::is_arithmetic<_Td>::value) {
+        // 分块 + SIMD，见 gemm.hpp
+        sjtu::gemm(a.RowSize(), b.ColSize(), a.ColSize(), a.data(), a.ColSize(),
+                   b.data(), b.ColSize(), c.data(), c.ColSize());
+        return;
+    }
+    // i-k-j order: the inner loop walks rows of b and c contiguously
     for (size_t i = 0; i < a.RowSize(); ++i) {
-        for (size_t j = 0; j < b.ColSize(); ++j) {
-            for (size_t k = 0; k < a.ColSize(); ++k) {
-                c[i][j] += a[i][k] * b[k][j];
+        _Td *ci = c.row_data(i);
+        const _Td *ai = a.row_data(i);
+        for (size_t k = 0; k < a.ColSize(); ++k) {
+            const _Td aik = ai[k];
+            const _Td *bk = b.row_data(k);
+            for (size_t j = 0; j < b.ColSize(); ++j) {
+                ci[j] += aik * bk[j];
             }
         }
     }
-    return c;
 }
 
 /**
- * Operations between a number and a matrix;
+ * Multiplication of two matrics.
  */
 template<typename _Td>
-Matrix<_Td> operator*(const Matrix<_Td> &a, const _Td &b)
+Matrix<_Td> operator*(const Matrix<_Td> &a, const Matrix<_Td> &b)
 {
-    Matrix<_Td> c(a.RowSize(), a.ColSize());
-    for (size_t i = 0; i < a.RowSize(); ++i) {
-        for (size_t j = 0; j < a.ColSize(); ++j) {
-            c[i][j] = a[i][j] * b;
-        }
-    }
+    Matrix<_Td> c;
+    Multiply(c, a, b);
     return c;
 }
 
+/**
+ * Operations between a number and a matrix; the number must not be wider
+ * than the element type, so Matrix<int> * 2.5 does not compile
+ */
+template<typename E, typename S, typename = std::enable_if_t<ExprScalar<S, typename E::value_type>::value>>
+MatrixScalarExpr<E, typename E::value_type, ExprMul> operator*(const MatrixExpr<E> &a, const S &b)
+{
+    return MatrixScalarExpr<E, typename E::value_type, ExprMul>(a.self(), b);
+}
+
+template<typename E, typename S, typename = std::enable_if_t<ExprScalar<S, typename E::value_type>::value>>
+MatrixScalarExpr<E, typename E::value_type, ExprMul> operator*(const S &b, const MatrixExpr<E> &a)
+{
+    return MatrixScalarExpr<E, typename E::value_type, ExprMul>(a.self(), b);
+}
+
+template<typename E>
+MatrixScalarExpr<E, double, ExprDiv> operator/(const MatrixExpr<E> &a, const double &b)
+{
+    return MatrixScalarExpr<E, double, ExprDiv>(a.self(), b);
+}
+
+/**
+ * rows of e as (pointer, row stride) for gemm: matrices and views with
+ * contiguous rows are used in place, anything else is evaluated into tmp
+ */
+template<typename E, typename _Td>
+const _Td * product_operand(const E &e, Matrix<_Td> &tmp, size_t &ld)
+{
+    tmp = Matrix<_Td>(e);
+    ld = tmp.ColSize();
+    return tmp.data();
+}
 template<typename _Td>
-Matrix<_Td> operator*(const _Td &b, const Matrix<_Td> &a)
+const _Td * product_operand(const Matrix<_Td> &e, Matrix<_Td> &, size_t &ld)
 {
-    Matrix<_Td> c(a.RowSize(), a.ColSize());
-    for (size_t i = 0; i < a.RowSize(); ++i) {
-        for (size_t j = 0; j < a.ColSize(); ++j) {
-            c[i][j] = a[i][j] * b;
-        }
+    ld = e.ColSize();
+    return e.data();
+}
+template<typename _Td, typename View>
+const _Td * strided_product_operand(const View &e, Matrix<_Td> &tmp, size_t &ld)
+{
+    if (e.ColStride() == 1 && e.RowStride() >= 0) {
+        ld = e.RowStride();
+        return e.data();
     }
-    return c;
+    return product_operand<View, _Td>(e, tmp, ld);
 }
-
 template<typename _Td>
-Matrix<_Td> operator/(const Matrix<_Td> &a, const double &b)
+const _Td * product_operand(const ConstMatrixView<_Td> &e, Matrix<_Td> &tmp, size_t &ld)
 {
-    Matrix<_Td> c(a.RowSize(), a.ColSize());
-    for (size_t i = 0; i < a.RowSize(); ++i) {
-        for (size_t j = 0; j < a.ColSize(); ++j) {
-            c[i][j] = a[i][j] / b;
+    return strided_product_operand(e, tmp, ld);
+}
+template<typename _Td>
+const _Td * product_operand(const MatrixView<_Td> &e, Matrix<_Td> &tmp, size_t &ld)
+{
+    return strided_product_operand(e, tmp, ld);
+}
+
+// products involving an expression or a view
+template<typename L, typename R>
+Matrix<typename L::value_type> operator*(const MatrixExpr<L> &a, const MatrixExpr<R> &b)
+{
+    using _Td = typename L::value_type;
+    const L &l = a.self();
+    const R &r = b.self();
+    if constexpr (std::is_arithmetic<_Td>::value && std::is_same<_Td, typename R::value_type>::value) {
+        if (l.ColSize() != r.RowSize()) {
+            throw std::invalid_argument("different matrics\'s sizes");
         }
+        Matrix<_Td> ta, tb, c(l.RowSize(), r.ColSize(), 0);
+        size_t lda, ldb;
+        const _Td *pa = product_operand(l, ta, lda);
+        const _Td *pb = product_operand(r, tb, ldb);
+        sjtu::gemm(l.RowSize(), r.ColSize(), l.ColSize(), pa, lda, pb, ldb, c.data(), c.ColSize());
+        return c;
+    } else {
+        return Matrix<_Td>(a) * Matrix<_Td>(b);
     }
-    return c;
+}
+
+template<typename _Td>
+Matrix<_Td> & Matrix<_Td>::operator*=(const Matrix<_Td> &rhs)
+{
+    return *this = *this * rhs;
 }
 
 template<typename _Td>
@@ -214,11 +800,161 @@ Matrix<_Td> Transpose(const Matrix<_Td> &a)
     return res;
 }
 
+template<typename E>
+Matrix<typename E::value_type> Transpose(const MatrixExpr<E> &a)
+{
+    return Transpose(Matrix<typename E::value_type>(a));
+}
+
+// element types written and read with to_chars / from_chars
+template<typename _Td>
+struct TextNumber : std::integral_constant<bool,
+    (std::is_integral<_Td>::value && !std::is_same<_Td, bool>::value && !std::is_same<_Td, char>::value
+     && !std::is_same<_Td, signed char>::value && !std::is_same<_Td, unsigned char>::value
+     && !std::is_same<_Td, wchar_t>::value && !std::is_same<_Td, char16_t>::value
+     && !std::is_same<_Td, char32_t>::value)
+    || std::is_same<_Td, float>::value || std::is_same<_Td, double>::value> {};
+
+/**
+ * append mat to out as text: a '\n', then one line per row with every
+ * element right aligned in width characters (width 0: separated by one
+ * space), floating point fixed with precision decimals. the defaults give
+ * exactly the bytes operator<< writes to a stream in its default state.
+ * numbers go through std::to_chars straight into out
+ */
+template<typename _Td>
+void FormatMatrix(std::string &out, const Matrix<_Td> &mat, int width = 15, int precision = 8)
+{
+    out += '\n';
+    if constexpr (TextNumber<_Td>::value) {
+        // fixed 形式最长：符号 + 整数位 + '.' + precision 位小数
+        const size_t longest = (std::is_floating_point<_Td>::value ? 48 + 310 + precision : 48);
+        const size_t slot = std::max<size_t>(longest, width) + 1;
+        std::string num(longest, '\0');
+        for (size_t i = 0; i < mat.RowSize(); ++i) {
+            size_t pos = out.size();
+            out.resize(pos + slot * mat.ColSize() + 1);
+            char *p = &out[pos];
+            const _Td *row = mat.row_data(i);
+            for (size_t j = 0; j < mat.ColSize(); ++j) {
+                std::to_chars_result r;
+                if constexpr (std::is_floating_point<_Td>::value) {
+                    r = std::to_chars(&num[0], &num[0] + longest, row[j], std::chars_format::fixed, precision);
+                } else {
+                    r = std::to_chars(&num[0], &num[0] + longest, row[j]);
+                }
+                size_t len = r.ptr - &num[0];
+                if (width == 0) {
+                    if (j > 0) {
+                        *p++ = ' ';
+                    }
+                } else if (len < (size_t)width) {
+                    std::memset(p, ' ', width - len);
+                    p += width - len;
+                }
+                std::memcpy(p, &num[0], len);
+                p += len;
+            }
+            *p++ = '\n';
+            out.resize(p - &out[0]);
+        }
+    } else {
+        std::ostringstream stream;
+        stream.precision(precision);
+        stream.setf(std::ios::fixed | std::ios::right);
+        for (size_t i = 0; i < mat.RowSize(); ++i) {
+            for (size_t j = 0; j < mat.ColSize(); ++j) {
+                if (width == 0 && j > 0) {
+                    stream << ' ';
+                }
+                stream << std::setw(width) << mat[i][j];
+            }
+            stream << '\n';
+        }
+        out += stream.str();
+    }
+}
+
+/**
+ * read a matrix in the text form of FormatMatrix (any width) from
+ * [first, last): an optional leading '\n', then one row per line up to a
+ * blank line or the end. return the position after the last row.
+ * throws std::invalid_argument on a bad number or ragged rows
+ */
+template<typename _Td>
+const char * ParseMatrix(const char *first, const char *last, Matrix<_Td> &out)
+{
+    static_assert(TextNumber<_Td>::value, "ParseMatrix needs a numeric element type");
+    std::vector<_Td> vals;
+    size_t rows = 0, cols = 0;
+    const char *p = first;
+    if (p != last && *p == '\n') {
+        ++p;
+    }
+    while (p != last && *p != '\n') {
+        size_t n = 0;
+        for (;;) {
+            while (p != last && (*p == ' ' || *p == '\t' || *p == '\r')) {
+                ++p;
+            }
+            if (p == last || *p == '\n') {
+                break;
+            }
+            _Td v;
+            std::from_chars_result r = std::from_chars(p, last, v);
+            if (r.ec != std::errc()) {
+                throw std::invalid_argument("bad matrix element");
+            }
+            vals.push_back(v);
+            p = r.ptr;
+            ++n;
+        }
+        if (p != last) {
+            ++p;
+        }
+        if (rows > 0 && n != cols) {
+            throw std::invalid_argument("different matrics\'s sizes");
+        }
+        cols = n;
+        ++rows;
+    }
+    out.assign(rows, cols, _Td());
+    if (!vals.empty()) {
+        std::memcpy(out.data(), vals.data(), vals.size() * sizeof(_Td));
+    }
+    return p;
+}
+
+/**
+ * whether stream is in the state operator<< formats for by default
+ * (classic locale, decimal, right aligned, ' ' fill, no pending width,
+ * no sign or base flags), so text from FormatMatrix can be written
+ * unchanged
+ */
+inline bool PlainTextStream(const std::ostream &stream)
+{
+    if (stream.getloc() != std::locale::classic()) {
+        return false;
+    }
+    std::ios::fmtflags f = stream.flags();
+    std::ios::fmtflags base = f & std::ios::basefield, adjust = f & std::ios::adjustfield,
+        floats = f & std::ios::floatfield;
+    return stream.fill() == ' ' && stream.width() == 0 && (base == 0 || base == std::ios::dec)
+        && (adjust == 0 || adjust == std::ios::right) && (floats == 0 || floats == std::ios::fixed)
+        && !(f & (std::ios::showpos | std::ios::showbase | std::ios::showpoint | std::ios::uppercase
+                  | std::ios::boolalpha));
+}
+
 template<typename _Td>
 std::ostream & operator<<(std::ostream &stream, const Matrix<_Td> &mat)
 {
+    if (PlainTextStream(stream)) {
+        std::string text;
+        FormatMatrix(text, mat);
+        return stream.write(text.data(), text.size());
+    }
     std::ostream::fmtflags oldFlags = stream.flags();
-    stream.precision(8);
+    std::streamsize oldPrecision = stream.precision(8);
     stream.setf(std::ios::fixed | std::ios::right);
 
     stream << '\n';
@@ -230,9 +966,55 @@ std::ostream & operator<<(std::ostream &stream, const Matrix<_Td> &mat)
     }
 
     stream.flags(oldFlags);
+    stream.precision(oldPrecision);
     return stream;
 }
 
+/**
+ * raw binary form: rows and cols as two uint64_t, then the elements as
+ * they are in memory (so only portable between machines of the same
+ * endianness). one write / read for the whole matrix
+ */
+template<typename _Td>
+std::ostream & WriteBinary(std::ostream &stream, const Matrix<_Td> &mat)
+{
+    static_assert(std::is_trivially_copyable<_Td>::value, "WriteBinary needs a trivially copyable element type");
+    uint64_t shape[2] = {mat.RowSize(), mat.ColSize()};
+    stream.write(reinterpret_cast<const char *>(shape), sizeof(shape));
+    return stream.write(reinterpret_cast<const char *>(mat.data()), mat.size() * sizeof(_Td));
+}
+
+/**
+ * false, with mat unchanged, if the stream ends early or its header
+ * holds a shape no Matrix can have (failbit is set then)
+ */
+template<typename _Td>
+bool ReadBinary(std::istream &stream, Matrix<_Td> &mat)
+{
+    static_assert(std::is_trivially_copyable<_Td>::value, "ReadBinary needs a trivially copyable element type");
+    uint64_t shape[2];
+    if (!stream.read(reinterpret_cast<char *>(shape), sizeof(shape))) {
+        return false;
+    }
+    const uint64_t most = Matrix<_Td>::MaxSize();
+    if (std::max(shape[0], shape[1]) > most || (shape[1] != 0 && shape[0] > most / shape[1])) {
+        stream.setstate(std::ios::failbit);
+        return false;
+    }
+    Matrix<_Td> res(shape[0], shape[1]);
+    if (!stream.read(reinterpret_cast<char *>(res.data()), res.size() * sizeof(_Td))) {
+        return false;
+    }
+    mat = std::move(res);
+    return true;
+}
+
+template<typename E>
+std::ostream & operator<<(std::ostream &stream, const MatrixExpr<E> &expr)
+{
+    return stream << Matrix<typename E::value_type>(expr);
+}
+
 template<typename _Td>
 Matrix<_Td> I(const size_t &n)
 {
@@ -243,21 +1025,120 @@ Matrix<_Td> I(const size_t &n)
     return res;
 }
 
+// hash of the shape and elements of a, equal for equal trivially copyable contents
 template<typename _Td>
-Matrix<_Td> Pow(Matrix<_Td> A, size_t &b)
+uint64_t Fingerprint(const Matrix<_Td> &a)
 {
-    if (A.RowSize() != A.ColSize()) {
-        throw std::invalid_argument("The row size and column size are different.");
+    uint64_t h = sjtu::mix_hash(a.RowSize() * 0x100000001b3ULL ^ a.ColSize());
+    if constexpr (std::is_trivially_copyable<_Td>::value) {
+        h = sjtu::hash_bytes(a.data(), a.size() * sizeof(_Td), h);
     }
-    Matrix<_Td> result = I<_Td>(A.ColSize());
-    while (b > 0) {
-        if (b & static_cast<size_t>(1)) {
-            result = result * A;
+    return h;
+}
+
+/**
+ * the buffers for raising square matrices to powers by repeated squaring.
+ * the running square and the result ping-pong with one spare matrix, so
+ * once they have grown to size a power allocates nothing.
+ *
+ * with cache_squares, A, A^2, A^4, ... are kept for the last base (found
+ * again by its Fingerprint and an exact compare): later powers of the same
+ * base reuse them and cost one product per set bit of the exponent.
+ */
+template<typename _Td>
+class PowWorkspace {
+    Matrix<_Td> cur, spare;
+    bool cache_squares;
+    uint64_t base_print = 0;
+    std::vector<Matrix<_Td>> squares; // squares[k] == A^(2^k)
+
+    // result = result * m, or result = m for the first factor
+    void accumulate(Matrix<_Td> &result, const Matrix<_Td> &m, bool &first)
+    {
+        if (first) {
+            result = m;
+            first = false;
+        } else {
+            Multiply(spare, result, m);
+            std::swap(spare, result);
+        }
+    }
+public:
+    explicit PowWorkspace(bool _cache_squares = false) : cache_squares(_cache_squares) {}
+
+    // result = A^b; result may be A
+    void power(const Matrix<_Td> &A, size_t b, Matrix<_Td> &result)
+    {
+        if (A.RowSize() != A.ColSize()) {
+            throw std::invalid_argument("The row size and column size are different.");
+        }
+        if (b == 0) {
+            result.assign(A.RowSize(), A.ColSize(), 0);
+            for (size_t i = 0; i < A.RowSize(); ++i) {
+                result.row_data(i)[i] = static_cast<_Td>(1);
+            }
+            return;
+        }
+        bool first = true;
+        if (!cache_squares) {
+            cur = A;
+            for (;;) {
+                if (b & static_cast<size_t>(1)) {
+                    accumulate(result, cur, first);
+                }
+                b >>= 1;
+                if (b == 0)
+                    break;
+                Multiply(spare, cur, cur);
+                std::swap(spare, cur);
+            }
+            return;
+        }
+        uint64_t print = Fingerprint(A);
+        if (squares.empty() || print != base_print || !(squares[0] == A)) {
+            squares.clear();
+            squares.push_back(A);
+            base_print = print;
         }
-        A = A * A;
-        b = b >> static_cast<size_t>(1);
+        for (size_t k = 0; b > 0; ++k, b >>= 1) {
+            if (k == squares.size()) {
+                Matrix<_Td> sq;
+                Multiply(sq, squares.back(), squares.back());
+                squares.push_back(std::move(sq));
+            }
+            if (b & static_cast<size_t>(1)) {
+                accumulate(result, squares[k], first);
+            }
+        }
+    }
+    Matrix<_Td> power(const Matrix<_Td> &A, size_t b)
+    {
+        Matrix<_Td> result;
+        power(A, b, result);
+        return result;
     }
-    return result;
+    // forget the cached squares
+    void clear()
+    {
+        squares.clear();
+    }
+    size_t cached_squares() const
+    {
+        return squares.size();
+    }
+};
+
+// the exponent is taken by value: the caller's copy is left unchanged
+template<typename _Td>
+Matrix<_Td> Pow(const Matrix<_Td> &A, size_t b)
+{
+    return PowWorkspace<_Td>().power(A, b);
+}
+
+template<typename E>
+Matrix<typename E::value_type> Pow(const MatrixExpr<E> &A, size_t b)
+{
+    return Pow(Matrix<typename E::value_type>(A), b);
 }
 
 #endif
@@ -0,0 +1,80 @@
+#ifndef SJTU_COMPRESS_HPP
+#define SJTU_COMPRESS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "class-matrix.hpp"
+
+namespace sjtu {
+
+/**
+ * a Matrix of an integral type stored as the zigzag varint encoded
+ * differences between consecutive elements in row-major order.
+ * smooth or repetitive data (e.g. Matrix<int>(2, 2, i)) packs into a
+ * byte or two per element instead of sizeof(_Td).
+ */
+template <class _Td> class packed_matrix {
+  static_assert(std::is_integral<_Td>::value && sizeof(_Td) <= 8,
+                "packed_matrix needs an integral element type");
+  using U = typename std::make_unsigned<_Td>::type;
+  using S = typename std::make_signed<_Td>::type;
+
+  size_t n_rows = 0;
+  size_t n_cols = 0;
+  std::vector<uint8_t> bytes;
+
+  void put(uint64_t z) {
+    while (z >= 0x80) {
+      bytes.push_back(uint8_t(z) | 0x80);
+      z >>= 7;
+    }
+    bytes.push_back(uint8_t(z));
+  }
+
+public:
+  packed_matrix() = default;
+  explicit packed_matrix(const Matrix<_Td> &mat)
+      : n_rows(mat.RowSize()), n_cols(mat.ColSize()) {
+    bytes.reserve(n_rows * n_cols + 8);
+    U prev = 0;
+    const _Td *src = mat.data();
+    for (size_t i = 0; i < mat.size(); ++i) {
+      U cur = U(src[i]);
+      int64_t d = S(U(cur - prev)); // 按元素类型的位宽回绕
+      put((uint64_t(d) << 1) ^ uint64_t(d >> 63));
+      prev = cur;
+    }
+    bytes.shrink_to_fit();
+  }
+
+  size_t RowSize() const { return n_rows; }
+  size_t ColSize() const { return n_cols; }
+  // bytes held by the encoded data
+  size_t packed_size() const { return bytes.capacity(); }
+
+  Matrix<_Td> unpack() const {
+    Matrix<_Td> mat(n_rows, n_cols);
+    const uint8_t *p = bytes.data();
+    U prev = 0;
+    _Td *dst = mat.data();
+    for (size_t i = 0; i < mat.size(); ++i) {
+      uint64_t z = 0;
+      for (int shift = 0;; shift += 7) {
+        z |= uint64_t(*p & 0x7f) << shift;
+        if (!(*p++ & 0x80))
+          break;
+      }
+      int64_t d = int64_t(z >> 1) ^ -int64_t(z & 1);
+      prev = U(prev + U(d));
+      dst[i] = _Td(prev);
+    }
+    return mat;
+  }
+};
+
+} // namespace sjtu
+
+#endif
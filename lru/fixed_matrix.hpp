@@ -0,0 +1,180 @@
+#ifndef SJTU_FIXED_MATRIX_HPP
+#define SJTU_FIXED_MATRIX_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "class-matrix.hpp"
+
+/**
+ * an R x C matrix whose elements live inline in a std::array, so it
+ * never allocates: a linked_hashmap<Integer, FixedMatrix<int, 2, 2>>
+ * node holds its value with no further allocation, and so does a
+ * sjtu::basic_lru<FixedMatrix<int, 2, 2>> until a value is shared (see
+ * inline_cell). sizes are constants,
+ * element-wise arithmetic is expanded at compile time, and mixing with
+ * Matrix works through MatrixExpr (a Matrix can be built from a
+ * FixedMatrix, and the other way round with an explicit size check).
+ */
+template<typename _Td, size_t R, size_t C>
+class FixedMatrix : public MatrixExpr<FixedMatrix<_Td, R, C>> {
+    std::array<_Td, R * C> buf{};
+
+    template<typename F, size_t... I>
+    static constexpr FixedMatrix generate(F f, std::index_sequence<I...>)
+    {
+        FixedMatrix res;
+        ((res.buf[I] = f(I)), ...);
+        return res;
+    }
+public:
+    using value_type = _Td;
+
+    // res.elem(i) = f(i) for every i, expanded without a loop
+    template<typename F>
+    static constexpr FixedMatrix generate(F f)
+    {
+        return generate(f, std::make_index_sequence<R * C>());
+    }
+
+    constexpr FixedMatrix() = default;
+    constexpr explicit FixedMatrix(const _Td &fillValue)
+        : FixedMatrix(generate([&fillValue](size_t) { return fillValue; })) {}
+    // throws std::invalid_argument if expr is not R x C
+    template<typename E>
+    explicit FixedMatrix(const MatrixExpr<E> &expr)
+    {
+        const E &e = expr.self();
+        if (e.RowSize() != R || e.ColSize() != C) {
+            throw std::invalid_argument("different matrics\'s sizes");
+        }
+        for (size_t i = 0; i < R * C; ++i) {
+            buf[i] = e.elem(i);
+        }
+    }
+
+    static constexpr size_t RowSize() { return R; }
+    static constexpr size_t ColSize() { return C; }
+    static constexpr size_t size() { return R * C; }
+
+    // row Kth, indexable with a second []
+    constexpr _Td * operator[](const size_t &Kth)
+    {
+        return buf.data() + Kth * C;
+    }
+    constexpr const _Td * operator[](const size_t &Kth) const
+    {
+        return buf.data() + Kth * C;
+    }
+    constexpr _Td * data() { return buf.data(); }
+    constexpr const _Td * data() const { return buf.data(); }
+    constexpr const _Td & elem(size_t i) const { return buf[i]; }
+    template<typename T>
+    bool aliases(const ExprTarget<T> &dst) const
+    {
+        return dst.clobbers(data(), R, C, C, 1);
+    }
+
+    FixedMatrix & operator+=(const FixedMatrix &rhs)
+    {
+        return *this = *this + rhs;
+    }
+    FixedMatrix & operator-=(const FixedMatrix &rhs)
+    {
+        return *this = *this - rhs;
+    }
+    template<typename S, typename = std::enable_if_t<ExprScalar<S, _Td>::value>>
+    FixedMatrix & operator*=(const S &scalar)
+    {
+        return *this = *this * scalar;
+    }
+};
+
+// inside a mixed expression a FixedMatrix is referenced, like a Matrix
+template<typename _Td, size_t R, size_t C>
+struct ExprOperand<FixedMatrix<_Td, R, C>> {
+    using type = const FixedMatrix<_Td, R, C> &;
+};
+
+template<typename _Td, size_t R, size_t C>
+constexpr FixedMatrix<_Td, R, C> operator+(const FixedMatrix<_Td, R, C> &a, const FixedMatrix<_Td, R, C> &b)
+{
+    return FixedMatrix<_Td, R, C>::generate([&](size_t i) { return _Td(a.elem(i) + b.elem(i)); });
+}
+
+template<typename _Td, size_t R, size_t C>
+constexpr FixedMatrix<_Td, R, C> operator-(const FixedMatrix<_Td, R, C> &a, const FixedMatrix<_Td, R, C> &b)
+{
+    return FixedMatrix<_Td, R, C>::generate([&](size_t i) { return _Td(a.elem(i) - b.elem(i)); });
+}
+
+template<typename _Td, size_t R, size_t C>
+constexpr FixedMatrix<_Td, R, C> operator-(const FixedMatrix<_Td, R, C> &a)
+{
+    return FixedMatrix<_Td, R, C>::generate([&](size_t i) { return _Td(-a.elem(i)); });
+}
+
+// like Matrix, a scalar must not be wider than _Td
+template<typename _Td, size_t R, size_t C, typename S, typename = std::enable_if_t<ExprScalar<S, _Td>::value>>
+constexpr FixedMatrix<_Td, R, C> operator*(const FixedMatrix<_Td, R, C> &a, const S &b)
+{
+    return FixedMatrix<_Td, R, C>::generate([&](size_t i) { return _Td(a.elem(i) * b); });
+}
+
+template<typename _Td, size_t R, size_t C, typename S, typename = std::enable_if_t<ExprScalar<S, _Td>::value>>
+constexpr FixedMatrix<_Td, R, C> operator*(const S &b, const FixedMatrix<_Td, R, C> &a)
+{
+    return a * b;
+}
+
+template<typename _Td, size_t R, size_t C>
+constexpr FixedMatrix<_Td, R, C> operator/(const FixedMatrix<_Td, R, C> &a, const double &b)
+{
+    return FixedMatrix<_Td, R, C>::generate([&](size_t i) { return _Td(a.elem(i) / b); });
+}
+
+/**
+ * Multiplication of two matrics, sizes checked at compile time.
+ */
+template<typename _Td, size_t R, size_t K, size_t C>
+constexpr FixedMatrix<_Td, R, C> operator*(const FixedMatrix<_Td, R, K> &a, const FixedMatrix<_Td, K, C> &b)
+{
+    return FixedMatrix<_Td, R, C>::generate([&](size_t idx) {
+        const size_t i = idx / C, j = idx % C;
+        _Td sum = 0;
+        for (size_t k = 0; k < K; ++k) {
+            sum += a.elem(i * K + k) * b.elem(k * C + j);
+        }
+        return sum;
+    });
+}
+
+template<typename _Td, size_t R, size_t C>
+constexpr bool operator==(const FixedMatrix<_Td, R, C> &a, const FixedMatrix<_Td, R, C> &b)
+{
+    for (size_t i = 0; i < R * C; ++i) {
+        if (a.elem(i) != b.elem(i))
+            return false;
+    }
+    return true;
+}
+
+// hash of the elements, so an lru of FixedMatrix values can intern them
+template<typename _Td, size_t R, size_t C>
+uint64_t Fingerprint(const FixedMatrix<_Td, R, C> &a)
+{
+    static_assert(std::is_trivially_copyable<_Td>::value, "Fingerprint hashes the element bytes");
+    return sjtu::hash_bytes(a.data(), R * C * sizeof(_Td), sjtu::mix_hash(R * 0x100000001b3ULL ^ C));
+}
+
+template<typename _Td, size_t R, size_t C>
+constexpr FixedMatrix<_Td, C, R> Transpose(const FixedMatrix<_Td, R, C> &a)
+{
+    return FixedMatrix<_Td, C, R>::generate([&](size_t idx) { return a.elem(idx % R * C + idx / R); });
+}
+
+#endif
@@ -0,0 +1,381 @@
+#ifndef SJTU_GEMM_HPP
+#define SJTU_GEMM_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SJTU_GEMM_X86 1
+#include <immintrin.h>
+#else
+#define SJTU_GEMM_X86 0
+#endif
+
+namespace sjtu {
+
+// instruction set used by gemm(), chosen once from the running cpu
+enum class gemm_isa { scalar, avx2 };
+
+inline gemm_isa detect_gemm_isa() {
+#if SJTU_GEMM_X86
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    return gemm_isa::avx2;
+#endif
+  return gemm_isa::scalar;
+}
+
+namespace gemm_detail {
+inline std::atomic<gemm_isa> &dispatch() {
+  static std::atomic<gemm_isa> isa{detect_gemm_isa()};
+  return isa;
+}
+} // namespace gemm_detail
+
+// the kernels gemm() runs
+inline gemm_isa gemm_dispatch() {
+  return gemm_detail::dispatch().load(std::memory_order_relaxed);
+}
+
+/**
+ * choose the kernels gemm() runs, e.g. scalar to compare against. return
+ * false and keep the current ones if the cpu does not support isa
+ */
+inline bool set_gemm_dispatch(gemm_isa isa) {
+  if (isa == gemm_isa::avx2 && detect_gemm_isa() != gemm_isa::avx2)
+    return false;
+  gemm_detail::dispatch().store(isa, std::memory_order_relaxed);
+  return true;
+}
+
+/**
+ * threads: how many threads (the caller included) share one product,
+ * 1 (the default) keeps gemm() serial; hardware_concurrency() is the
+ * usual choice otherwise. threshold: products with fewer multiply-adds
+ * stay serial. both may be changed from any thread and take effect for
+ * the next product.
+ */
+struct gemm_parallel_config {
+  std::atomic<size_t> threads{1};
+  std::atomic<size_t> threshold{128 * 128 * 128};
+};
+
+inline gemm_parallel_config &gemm_parallel() {
+  static gemm_parallel_config config;
+  return config;
+}
+
+namespace gemm_detail {
+
+/**
+ * goto-style blocking: C is computed in MR x NR tiles from an MR x KC
+ * strip of A and a KC x NR strip of B, both packed contiguously so the
+ * micro-kernel streams them from L1. an MC x KC block of A stays in L2,
+ * a KC x NC block of B in L3.
+ */
+constexpr size_t MR = 4;
+constexpr size_t KC = 256;
+constexpr size_t MC = 128;
+constexpr size_t NC = 1024;
+// two 256-bit vectors per row of the tile
+template <class T> constexpr size_t nr() { return 64 / sizeof(T); }
+
+// products below this many multiply-adds skip packing
+constexpr size_t SMALL = 32 * 32 * 32;
+
+template <class T>
+void naive(size_t m, size_t n, size_t k, const T *a, size_t lda, const T *b,
+           size_t ldb, T *c, size_t ldc) {
+  for (size_t i = 0; i < m; ++i) {
+    for (size_t p = 0; p < k; ++p) {
+      const T aip = a[i * lda + p];
+      const T *bp = b + p * ldb;
+      T *ci = c + i * ldc;
+      for (size_t j = 0; j < n; ++j)
+        ci[j] += aip * bp[j];
+    }
+  }
+}
+
+// rows [0, mc) x cols [0, kc) of a as MR-row strips, p-major, zero padded
+template <class T>
+void pack_a(size_t mc, size_t kc, const T *a, size_t lda, T *dst) {
+  for (size_t i = 0; i < mc; i += MR) {
+    size_t rows = std::min(MR, mc - i);
+    for (size_t p = 0; p < kc; ++p) {
+      for (size_t r = 0; r < MR; ++r)
+        *dst++ = r < rows ? a[(i + r) * lda + p] : T(0);
+    }
+  }
+}
+
+// rows [0, kc) x cols [0, nc) of b as NR-column strips, zero padded
+template <class T>
+void pack_b(size_t kc, size_t nc, const T *b, size_t ldb, T *dst) {
+  constexpr size_t NR = nr<T>();
+  for (size_t j = 0; j < nc; j += NR) {
+    size_t cols = std::min(NR, nc - j);
+    for (size_t p = 0; p < kc; ++p) {
+      const T *src = b + p * ldb + j;
+      for (size_t c = 0; c < cols; ++c)
+        *dst++ = src[c];
+      for (size_t c = cols; c < NR; ++c)
+        *dst++ = T(0);
+    }
+  }
+}
+
+// add the m x n corner of a full MR x NR tile to c
+template <class T>
+void add_tile(size_t m, size_t n, const T *tile, T *c, size_t ldc) {
+  constexpr size_t NR = nr<T>();
+  for (size_t r = 0; r < m; ++r) {
+    for (size_t j = 0; j < n; ++j)
+      c[r * ldc + j] += tile[r * NR + j];
+  }
+}
+
+template <class T>
+void micro_scalar(size_t kc, const T *a, const T *b, size_t m, size_t n, T *c,
+                  size_t ldc) {
+  constexpr size_t NR = nr<T>();
+  T acc[MR * NR] = {};
+  for (size_t p = 0; p < kc; ++p) {
+    for (size_t r = 0; r < MR; ++r) {
+      const T ar = a[p * MR + r];
+      for (size_t j = 0; j < NR; ++j)
+        acc[r * NR + j] += ar * b[p * NR + j];
+    }
+  }
+  add_tile(m, n, acc, c, ldc);
+}
+
+#if SJTU_GEMM_X86
+/**
+ * avx2 micro-kernels: the MR x NR tile lives in 8 ymm accumulators,
+ * each step broadcasts one element of a against two vectors of b
+ */
+__attribute__((target("avx2,fma"))) inline void
+micro_avx2(size_t kc, const double *a, const double *b, size_t m, size_t n,
+           double *c, size_t ldc) {
+  __m256d acc[MR][2];
+  for (size_t r = 0; r < MR; ++r)
+    acc[r][0] = acc[r][1] = _mm256_setzero_pd();
+  for (size_t p = 0; p < kc; ++p) {
+    __m256d b0 = _mm256_loadu_pd(b + p * 8);
+    __m256d b1 = _mm256_loadu_pd(b + p * 8 + 4);
+    for (size_t r = 0; r < MR; ++r) {
+      __m256d ar = _mm256_broadcast_sd(a + p * MR + r);
+      acc[r][0] = _mm256_fmadd_pd(ar, b0, acc[r][0]);
+      acc[r][1] = _mm256_fmadd_pd(ar, b1, acc[r][1]);
+    }
+  }
+  if (m == MR && n == 8) {
+    for (size_t r = 0; r < MR; ++r) {
+      double *cr = c + r * ldc;
+      _mm256_storeu_pd(cr, _mm256_add_pd(_mm256_loadu_pd(cr), acc[r][0]));
+      _mm256_storeu_pd(cr + 4,
+                       _mm256_add_pd(_mm256_loadu_pd(cr + 4), acc[r][1]));
+    }
+    return;
+  }
+  alignas(32) double tile[MR * 8];
+  for (size_t r = 0; r < MR; ++r) {
+    _mm256_store_pd(tile + r * 8, acc[r][0]);
+    _mm256_store_pd(tile + r * 8 + 4, acc[r][1]);
+  }
+  add_tile(m, n, tile, c, ldc);
+}
+
+__attribute__((target("avx2,fma"))) inline void
+micro_avx2(size_t kc, const float *a, const float *b, size_t m, size_t n,
+           float *c, size_t ldc) {
+  __m256 acc[MR][2];
+  for (size_t r = 0; r < MR; ++r)
+    acc[r][0] = acc[r][1] = _mm256_setzero_ps();
+  for (size_t p = 0; p < kc; ++p) {
+    __m256 b0 = _mm256_loadu_ps(b + p * 16);
+    __m256 b1 = _mm256_loadu_ps(b + p * 16 + 8);
+    for (size_t r = 0; r < MR; ++r) {
+      __m256 ar = _mm256_broadcast_ss(a + p * MR + r);
+      acc[r][0] = _mm256_fmadd_ps(ar, b0, acc[r][0]);
+      acc[r][1] = _mm256_fmadd_ps(ar, b1, acc[r][1]);
+    }
+  }
+  if (m == MR && n == 16) {
+    for (size_t r = 0; r < MR; ++r) {
+      float *cr = c + r * ldc;
+      _mm256_storeu_ps(cr, _mm256_add_ps(_mm256_loadu_ps(cr), acc[r][0]));
+      _mm256_storeu_ps(cr + 8,
+                       _mm256_add_ps(_mm256_loadu_ps(cr + 8), acc[r][1]));
+    }
+    return;
+  }
+  alignas(32) float tile[MR * 16];
+  for (size_t r = 0; r < MR; ++r) {
+    _mm256_store_ps(tile + r * 16, acc[r][0]);
+    _mm256_store_ps(tile + r * 16 + 8, acc[r][1]);
+  }
+  add_tile(m, n, tile, c, ldc);
+}
+
+// int products wrap like the scalar kernel does in practice
+__attribute__((target("avx2"))) inline void
+micro_avx2(size_t kc, const int *a, const int *b, size_t m, size_t n, int *c,
+           size_t ldc) {
+  __m256i acc[MR][2];
+  for (size_t r = 0; r < MR; ++r)
+    acc[r][0] = acc[r][1] = _mm256_setzero_si256();
+  for (size_t p = 0; p < kc; ++p) {
+    __m256i b0 = _mm256_loadu_si256((const __m256i *)(b + p * 16));
+    __m256i b1 = _mm256_loadu_si256((const __m256i *)(b + p * 16 + 8));
+    for (size_t r = 0; r < MR; ++r) {
+      __m256i ar = _mm256_set1_epi32(a[p * MR + r]);
+      acc[r][0] = _mm256_add_epi32(acc[r][0], _mm256_mullo_epi32(ar, b0));
+      acc[r][1] = _mm256_add_epi32(acc[r][1], _mm256_mullo_epi32(ar, b1));
+    }
+  }
+  alignas(32) int tile[MR * 16];
+  for (size_t r = 0; r < MR; ++r) {
+    _mm256_store_si256((__m256i *)(tile + r * 16), acc[r][0]);
+    _mm256_store_si256((__m256i *)(tile + r * 16 + 8), acc[r][1]);
+  }
+  add_tile(m, n, tile, c, ldc);
+}
+#endif
+
+template <class T> struct has_simd {
+  static constexpr bool value = std::is_same<T, int>::value ||
+                                std::is_same<T, float>::value ||
+                                std::is_same<T, double>::value;
+};
+
+template <class T>
+void micro(bool simd, size_t kc, const T *a, const T *b, size_t m, size_t n,
+           T *c, size_t ldc) {
+#if SJTU_GEMM_X86
+  if constexpr (has_simd<T>::value) {
+    if (simd) {
+      micro_avx2(kc, a, b, m, n, c, ldc);
+      return;
+    }
+  }
+#endif
+  micro_scalar(kc, a, b, m, n, c, ldc);
+}
+
+// the pool shared by every gemm(), rebuilt when the thread count changes
+inline std::shared_ptr<thread_pool> pool(size_t threads) {
+  static std::mutex mtx;
+  static std::shared_ptr<thread_pool> shared;
+  std::lock_guard<std::mutex> lock(mtx);
+  if (!shared || shared->size() != threads)
+    shared = std::make_shared<thread_pool>(threads);
+  return shared;
+}
+
+template <class T>
+void serial(size_t m, size_t n, size_t k, const T *a, size_t lda, const T *b,
+            size_t ldb, T *c, size_t ldc) {
+  if (m * n * k <= SMALL) {
+    naive(m, n, k, a, lda, b, ldb, c, ldc);
+    return;
+  }
+  constexpr size_t NR = nr<T>();
+  bool simd = gemm_dispatch() == gemm_isa::avx2;
+  // 打包缓冲区按线程复用
+  static thread_local std::vector<T> pa, pb;
+  pa.resize(MC * KC);
+  pb.resize(KC * (NC + NR));
+
+  for (size_t jc = 0; jc < n; jc += NC) {
+    size_t nc = std::min(NC, n - jc);
+    for (size_t pc = 0; pc < k; pc += KC) {
+      size_t kc = std::min(KC, k - pc);
+      pack_b(kc, nc, b + pc * ldb + jc, ldb, pb.data());
+      for (size_t ic = 0; ic < m; ic += MC) {
+        size_t mc = std::min(MC, m - ic);
+        pack_a(mc, kc, a + ic * lda + pc, lda, pa.data());
+        for (size_t jr = 0; jr < nc; jr += NR) {
+          for (size_t ir = 0; ir < mc; ir += MR) {
+            micro(simd, kc, pa.data() + ir * kc, pb.data() + jr * kc,
+                  std::min(MR, mc - ir), std::min(NR, nc - jr),
+                  c + (ic + ir) * ldc + jc + jr, ldc);
+          }
+        }
+      }
+    }
+  }
+}
+
+/**
+ * tile sizes for a product of c (m x n) over threads: start from MC x NC
+ * and halve the longer side, kept a multiple of MR or NR, until there are
+ * about four tiles per thread to steal from or the tiles get too thin to
+ * feed the micro-kernel. mid-sized products that fit in one MC x NC
+ * block are split this way too.
+ */
+inline void tile_grid(size_t m, size_t n, size_t threads, size_t nr,
+                      size_t &mb, size_t &nb) {
+  auto up = [](size_t x, size_t step) { return (x + step - 1) / step * step; };
+  mb = std::min(MC, up(m, MR));
+  nb = std::min(NC, up(n, nr));
+  while (((m + mb - 1) / mb) * ((n + nb - 1) / nb) < 4 * threads) {
+    if (nb >= mb && nb >= 8 * nr)
+      nb = up(nb / 2, nr);
+    else if (mb >= 8 * MR)
+      mb = up(mb / 2, MR);
+    else
+      break;
+  }
+}
+
+} // namespace gemm_detail
+
+/**
+ * c += a * b for row-major a (m x k), b (k x n) and c (m x n) with row
+ * strides lda, ldb, ldc. any arithmetic T works; int, float and double
+ * use avx2 micro-kernels when gemm_dispatch() allows.
+ * above gemm_parallel().threshold, c is cut into tiles sized by
+ * tile_grid from the thread count, spread over a thread_pool; each tile
+ * runs the serial kernel over the whole k. a
+ * product started while the pool is busy with another runs serially on
+ * its own thread instead of waiting for it.
+ */
+template <class T>
+void gemm(size_t m, size_t n, size_t k, const T *a, size_t lda, const T *b,
+          size_t ldb, T *c, size_t ldc) {
+  using namespace gemm_detail;
+  static_assert(std::is_arithmetic<T>::value, "gemm needs arithmetic T");
+  if (m == 0 || n == 0 || k == 0)
+    return;
+  const size_t threads = gemm_parallel().threads.load(std::memory_order_relaxed);
+  const size_t threshold =
+      gemm_parallel().threshold.load(std::memory_order_relaxed);
+  size_t mb = m, nb = n;
+  if (threads > 1 && m * n * k >= threshold)
+    tile_grid(m, n, threads, nr<T>(), mb, nb);
+  size_t row_tiles = (m + mb - 1) / mb, col_tiles = (n + nb - 1) / nb;
+  if (row_tiles * col_tiles == 1) {
+    serial(m, n, k, a, lda, b, ldb, c, ldc);
+    return;
+  }
+  std::shared_ptr<thread_pool> workers = pool(threads);
+  workers->parallel_for(row_tiles * col_tiles, [&](size_t t) {
+    size_t i = t / col_tiles * mb, j = t % col_tiles * nb;
+    serial(std::min(mb, m - i), std::min(nb, n - j), k, a + i * lda, lda,
+           b + j, ldb, c + i * ldc + j, ldc);
+  });
+}
+
+} // namespace sjtu
+
+#endif
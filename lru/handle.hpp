@@ -0,0 +1,173 @@
+#ifndef SJTU_HANDLE_HPP
+#define SJTU_HANDLE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace sjtu {
+
+/**
+ * the value and its reference counts, in one allocation. the value is
+ * destroyed with its last value_handle, the box itself once no
+ * weak_handle is left either (weak counts them plus one for all strong
+ * handles together)
+ */
+template <class T> struct handle_box {
+  std::atomic<size_t> refs;
+  std::atomic<size_t> weak;
+  union {
+    T val;
+  };
+  handle_box(const T &val) : refs(1), weak(1), val(val) {}
+  ~handle_box() {}
+};
+
+/**
+ * shared ownership of a T with the count stored next to the value, so a
+ * value costs one allocation and no separate control block.
+ * copies share the value; the last handle to go destroys it (a weak_handle
+ * can refer to it without keeping it alive). counting is
+ * thread-safe, the value itself is not synchronised and should be treated
+ * as read-only while shared between threads.
+ * a value_handle<T> converts to a read-only value_handle<const T> sharing
+ * the same value.
+ */
+template <class T> class value_handle {
+  template <class> friend class value_handle;
+  template <class> friend class weak_handle;
+  using stored = typename std::remove_const<T>::type;
+  using box = handle_box<stored>;
+  box *p = nullptr;
+
+  void release() {
+    if (p != nullptr && p->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      p->val.~stored();
+      if (p->weak.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        delete p;
+    }
+    p = nullptr;
+  }
+  // takes over a reference already counted
+  explicit value_handle(box *p) : p(p) {}
+
+public:
+  value_handle() = default;
+  // 隐式转换：缓存里存的是 val 的一份拷贝
+  value_handle(const T &val) : p(new box(val)) {}
+  value_handle(const value_handle &other) : p(other.p) {
+    if (p != nullptr)
+      p->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+  value_handle(value_handle &&other) noexcept : p(other.p) {
+    other.p = nullptr;
+  }
+  template <class U, class = typename std::enable_if<
+                         std::is_same<const U, T>::value>::type>
+  value_handle(const value_handle<U> &other) : p(other.p) {
+    if (p != nullptr)
+      p->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+  value_handle &operator=(value_handle other) noexcept {
+    std::swap(p, other.p);
+    return *this;
+  }
+  ~value_handle() { release(); }
+
+  T &operator*() const { return p->val; }
+  T *operator->() const { return &(p->val); }
+  T *get() const { return p == nullptr ? nullptr : &(p->val); }
+  explicit operator bool() const { return p != nullptr; }
+
+  size_t use_count() const {
+    return p == nullptr ? 0 : p->refs.load(std::memory_order_relaxed);
+  }
+  void reset() { release(); }
+};
+
+/**
+ * refers to the value of a value_handle without keeping it alive: lock()
+ * returns a handle sharing the value while some value_handle still holds
+ * it, an empty one after the last has gone. only the box outlives the
+ * value, not whatever memory the value owned.
+ */
+template <class T> class weak_handle {
+  using box = handle_box<typename std::remove_const<T>::type>;
+  box *p = nullptr;
+
+  void release() {
+    if (p != nullptr && p->weak.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      delete p;
+    p = nullptr;
+  }
+
+public:
+  weak_handle() = default;
+  weak_handle(const value_handle<T> &val) : p(val.p) {
+    if (p != nullptr)
+      p->weak.fetch_add(1, std::memory_order_relaxed);
+  }
+  weak_handle(const weak_handle &other) : p(other.p) {
+    if (p != nullptr)
+      p->weak.fetch_add(1, std::memory_order_relaxed);
+  }
+  weak_handle &operator=(weak_handle other) noexcept {
+    std::swap(p, other.p);
+    return *this;
+  }
+  ~weak_handle() { release(); }
+
+  value_handle<T> lock() const {
+    if (p == nullptr)
+      return value_handle<T>();
+    size_t n = p->refs.load(std::memory_order_relaxed);
+    while (n != 0) {
+      if (p->refs.compare_exchange_weak(n, n + 1, std::memory_order_acq_rel,
+                                        std::memory_order_relaxed))
+        return value_handle<T>(p);
+    }
+    return value_handle<T>();
+  }
+  void reset() { release(); }
+};
+
+/**
+ * a T kept inline, for small trivially copyable values: holding one costs
+ * no allocation. share() moves the value into a handle_box the first time
+ * it has to outlive its holder, and from then on the cell reads and writes
+ * the boxed value like a value_handle<T> would. a cell built from a handle
+ * starts out boxed. not synchronised; share() changes the cell.
+ */
+template <class T> class inline_cell {
+  T val{};
+  value_handle<T> boxed;
+
+public:
+  inline_cell() = default;
+  inline_cell(const T &val) : val(val) {}
+  inline_cell(const value_handle<T> &boxed) : boxed(boxed) {}
+
+  T &operator*() { return boxed ? *boxed : val; }
+  const T &operator*() const { return boxed ? *boxed : val; }
+  T *operator->() { return &**this; }
+  const T *operator->() const { return &**this; }
+  T *get() { return &**this; }
+  const T *get() const { return &**this; }
+  explicit operator bool() const { return true; }
+
+  // 1 while the value is inline: nobody else can hold it
+  size_t use_count() const { return boxed ? boxed.use_count() : 1; }
+  bool shared() const { return bool(boxed); }
+  // the box holding the value, empty while it is still inline
+  const value_handle<T> &handle() const { return boxed; }
+  const value_handle<T> &share() {
+    if (!boxed)
+      boxed = value_handle<T>(val);
+    return boxed;
+  }
+};
+
+} // namespace sjtu
+
+#endif
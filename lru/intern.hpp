@@ -0,0 +1,91 @@
+#ifndef SJTU_INTERN_HPP
+#define SJTU_INTERN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "class-matrix.hpp"
+#include "handle.hpp"
+
+namespace sjtu {
+
+/**
+ * one shared copy per distinct value: intern(val) returns a handle to a
+ * value equal to val, reusing the pooled one when there is one, so keys
+ * mapping to equal values hold a single copy between them.
+ *
+ * values are found by Fingerprint(val) (for Matrix a hash over its
+ * contiguous elements) and confirmed with ==. the pool keeps a handle of
+ * its own to every value; one it is the last holder of is dropped when
+ * the table next fills up. not synchronised, the owner's lock must be
+ * held; values handed out are shared and must not be modified.
+ */
+template <class T> class intern_pool {
+  struct slot {
+    uint64_t hash = 0;
+    value_handle<T> val;
+  };
+  std::vector<slot> table; // 线性探测，容量是 2 的幂
+  size_t used = 0;
+
+  // keep only the values someone else still holds, in a table of cap slots
+  void rebuild(size_t cap) {
+    std::vector<slot> old(cap);
+    old.swap(table);
+    used = 0;
+    for (slot &s : old) {
+      if (s.val && s.val.use_count() > 1) {
+        size_t i = s.hash & (table.size() - 1);
+        while (table[i].val)
+          i = (i + 1) & (table.size() - 1);
+        table[i] = std::move(s);
+        ++used;
+      }
+    }
+  }
+
+public:
+  explicit intern_pool(size_t expected = 64) {
+    size_t cap = 16;
+    while (cap < expected * 2)
+      cap <<= 1;
+    table.resize(cap);
+  }
+
+  value_handle<T> intern(const T &val) {
+    uint64_t h = Fingerprint(val);
+    size_t mask = table.size() - 1;
+    size_t i = h & mask;
+    for (; table[i].val; i = (i + 1) & mask) {
+      if (table[i].hash == h && *table[i].val == val)
+        return table[i].val;
+    }
+    if ((used + 1) * 4 > table.size() * 3) {
+      // 先丢掉没人用的值，仍然很满才扩容
+      rebuild(table.size());
+      if (used * 4 > table.size())
+        rebuild(table.size() * 2);
+      return intern(val);
+    }
+    table[i].hash = h;
+    table[i].val = value_handle<T>(val);
+    ++used;
+    return table[i].val;
+  }
+
+  // distinct values pooled, including ones no longer used elsewhere
+  size_t size() const { return used; }
+
+  // drop the values only the pool holds
+  void purge() { rebuild(table.size()); }
+
+  void clear() {
+    table.assign(table.size(), slot());
+    used = 0;
+  }
+};
+
+} // namespace sjtu
+
+#endif
@@ -1,11 +1,41 @@
 #ifndef SJTU_LRU_HPP
 #define SJTU_LRU_HPP
 
+#include "bloom.hpp"
 #include "class-integer.hpp"
 #include "class-matrix.hpp"
+#include "compress.hpp"
 #include "exceptions.hpp"
+#include "fixed_matrix.hpp"
+#include "handle.hpp"
+#include "intern.hpp"
+#include "mapped_file.hpp"
+#include "mrc.hpp"
+#include "pressure.hpp"
+#include "sparse_matrix.hpp"
 #include "utility.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
 class Hash {
 public:
   unsigned int operator()(Integer lhs) const {
@@ -20,7 +50,223 @@ public:
   }
 };
 
+// set SJTU_LRU_STATS to 0 to compile the statistics counters out
+#ifndef SJTU_LRU_STATS
+#define SJTU_LRU_STATS 1
+#endif
+
 namespace sjtu {
+/**
+ * snapshot of the counters of a linked_hashmap or an lru.
+ * bytes is the current payload size, the others count events since
+ * construction or the last reset_stats().
+ */
+struct cache_stats {
+  size_t hits = 0;
+  size_t misses = 0;
+  size_t inserts = 0;
+  size_t updates = 0;
+  size_t evictions = 0;
+  size_t bytes = 0;
+};
+
+// approximate memory held by a cached value, used for the bytes counter
+template <class T> size_t value_bytes(const T &) { return sizeof(T); }
+template <class _Td> size_t value_bytes(const Matrix<_Td> &mat) {
+  return sizeof(mat) + mat.RowSize() * mat.ColSize() * sizeof(_Td);
+}
+template <class _Td> size_t value_bytes(const packed_matrix<_Td> &mat) {
+  return sizeof(mat) + mat.packed_size();
+}
+template <class _Td> size_t value_bytes(const SparseMatrix<_Td> &mat) {
+  return mat.footprint();
+}
+template <class T> size_t value_bytes(const value_handle<T> &val) {
+  return val ? value_bytes(*val) : 0;
+}
+template <class T> size_t value_bytes(const inline_cell<T> &val) {
+  return value_bytes(*val);
+}
+
+#if SJTU_LRU_STATS
+/**
+ * relaxed atomic counters: a snapshot may be taken from any thread
+ * without the owner's lock, and updates cost one uncontended add.
+ */
+class stats_counter {
+  std::atomic<size_t> hits{0};
+  std::atomic<size_t> misses{0};
+  std::atomic<size_t> inserts{0};
+  std::atomic<size_t> updates{0};
+  std::atomic<size_t> evictions{0};
+  std::atomic<size_t> bytes{0};
+
+  static void bump(std::atomic<size_t> &c, size_t d = 1) {
+    c.fetch_add(d, std::memory_order_relaxed);
+  }
+
+public:
+  stats_counter() = default;
+  // a copied container holds the same payload but starts with fresh events
+  stats_counter(const stats_counter &other) : bytes(other.bytes.load()) {}
+  stats_counter &operator=(const stats_counter &other) {
+    reset();
+    bytes.store(other.bytes.load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+    return *this;
+  }
+
+  void hit() { bump(hits); }
+  void miss() { bump(misses); }
+  void insert(size_t b, size_t count = 1) {
+    bump(inserts, count);
+    bump(bytes, b);
+  }
+  void update(size_t old_b, size_t new_b) {
+    bump(updates);
+    bytes.fetch_add(new_b - old_b, std::memory_order_relaxed);
+  }
+  void evict(size_t b) {
+    bump(evictions);
+    bytes.fetch_sub(b, std::memory_order_relaxed);
+  }
+  // the same entry changed representation
+  void adjust(size_t old_b, size_t new_b) {
+    bytes.fetch_add(new_b - old_b, std::memory_order_relaxed);
+  }
+  void clear() { bytes.store(0, std::memory_order_relaxed); }
+
+  cache_stats snapshot() const {
+    cache_stats s;
+    s.hits = hits.load(std::memory_order_relaxed);
+    s.misses = misses.load(std::memory_order_relaxed);
+    s.inserts = inserts.load(std::memory_order_relaxed);
+    s.updates = updates.load(std::memory_order_relaxed);
+    s.evictions = evictions.load(std::memory_order_relaxed);
+    s.bytes = bytes.load(std::memory_order_relaxed);
+    return s;
+  }
+  void reset() {
+    hits.store(0, std::memory_order_relaxed);
+    misses.store(0, std::memory_order_relaxed);
+    inserts.store(0, std::memory_order_relaxed);
+    updates.store(0, std::memory_order_relaxed);
+    evictions.store(0, std::memory_order_relaxed);
+  }
+};
+#else
+// every call compiles to nothing and stats() reads all zero
+class stats_counter {
+public:
+  void hit() {}
+  void miss() {}
+  void insert(size_t, size_t = 1) {}
+  void update(size_t, size_t) {}
+  void evict(size_t) {}
+  void adjust(size_t, size_t) {}
+  void clear() {}
+  cache_stats snapshot() const { return cache_stats(); }
+  void reset() {}
+};
+#endif
+
+/**
+ * takes memory retired by the containers (node chains from unlink(),
+ * release() or cut_front(), whole objects) and frees it later: on
+ * reclaim(), or right away on a background thread if asked for, so the
+ * thread that evicts or clears never pays for the destructors. one
+ * reclaimer can serve containers of different types. whatever is still
+ * pending is freed on destruction.
+ */
+class reclaimer {
+  struct item {
+    void *ptr;
+    void (*destroy)(void *);
+  };
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::vector<item> pending;
+  std::thread worker;
+  bool stopping = false;
+
+  static void free_all(std::vector<item> &batch) {
+    for (item &it : batch)
+      it.destroy(it.ptr);
+    batch.clear();
+  }
+
+  void run() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (!stopping) {
+      cv.wait(lock, [this] { return stopping || !pending.empty(); });
+      std::vector<item> batch;
+      batch.swap(pending);
+      lock.unlock();
+      free_all(batch);
+      lock.lock();
+    }
+  }
+
+  void push(void *ptr, void (*destroy)(void *)) {
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      pending.push_back({ptr, destroy});
+    }
+    if (worker.joinable())
+      cv.notify_one();
+  }
+
+public:
+  explicit reclaimer(bool background = false) {
+    if (background)
+      worker = std::thread(&reclaimer::run, this);
+  }
+  reclaimer(const reclaimer &) = delete;
+  reclaimer &operator=(const reclaimer &) = delete;
+  ~reclaimer() {
+    if (worker.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+      }
+      cv.notify_one();
+      worker.join();
+    }
+    reclaim();
+  }
+
+  // a null terminated chain of heap nodes linked through next
+  template <class Node> void retire_chain(Node *chain) {
+    if (chain == nullptr)
+      return;
+    push(chain, [](void *p) {
+      Node *cur = static_cast<Node *>(p);
+      while (cur) {
+        Node *next = cur->next;
+        delete cur;
+        cur = next;
+      }
+    });
+  }
+
+  // an object allocated with new
+  template <class T> void retire(T *obj) {
+    if (obj == nullptr)
+      return;
+    push(obj, [](void *p) { delete static_cast<T *>(p); });
+  }
+
+  // free everything retired so far on the calling thread
+  void reclaim() {
+    std::vector<item> batch;
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      batch.swap(pending);
+    }
+    free_all(batch);
+  }
+};
+
 template <class T> class double_list {
 private:
   struct node {
@@ -70,6 +316,7 @@ public:
       dl = t.dl;
       ptr = t.ptr;
     }
+    iterator &operator=(const iterator &t) = default;
     ~iterator() = default;
     /**
      * iter++
@@ -261,7 +508,9 @@ public:
   }
   iterator end() { return iterator(this, nullptr); }
 
-  iterator get_tail() const { return iterator(tail); }
+  iterator get_tail() const {
+    return iterator(const_cast<double_list *>(this), tail);
+  }
   iterator erase(iterator pos) {
     if (pos.ptr == nullptr)
       return end();
@@ -283,6 +532,24 @@ public:
 
     return (next) ? iterator(this, next) : end();
   }
+  /**
+   * relink pos at the tail without copying its value,
+   * iterators to it stay valid
+   */
+  void move_to_tail(iterator pos) {
+    node *p = pos.ptr;
+    if (p == nullptr || p == tail)
+      return;
+    if (p->prev)
+      p->prev->next = p->next;
+    else
+      head = p->next;
+    p->next->prev = p->prev;
+    p->prev = tail;
+    p->next = nullptr;
+    tail->next = p;
+    tail = p;
+  }
   /**
    * the following are operations of double list
    */
@@ -331,14 +598,81 @@ public:
     return false;
   }
   void clear() {
-    node *cur = head;
+    free_chain(head);
+    size = 0;
+    head = tail = nullptr;
+  }
+
+  // delete a null terminated chain of nodes
+  static void free_chain(node *cur) {
     while (cur) {
       node *tmp = cur;
       cur = cur->next;
       delete tmp;
     }
+  }
+
+  /**
+   * unlink pos and return its node (as a one node chain) instead of
+   * deleting it
+   */
+  node *unlink(iterator pos) {
+    node *p = pos.ptr;
+    if (p == nullptr)
+      return nullptr;
+    if (p->prev)
+      p->prev->next = p->next;
+    else
+      head = p->next;
+    if (p->next)
+      p->next->prev = p->prev;
+    else
+      tail = p->prev;
+    p->prev = p->next = nullptr;
+    size--;
+    return p;
+  }
+
+  // append a node taken from unlink(), possibly of another list
+  void link_tail(node *p) {
+    p->prev = tail;
+    p->next = nullptr;
+    if (tail != nullptr)
+      tail->next = p;
+    else
+      head = p;
+    tail = p;
+    size++;
+  }
+
+  /**
+   * empty the list in O(1), returning the old nodes as one chain
+   */
+  node *release() {
+    node *chain = head;
     size = 0;
     head = tail = nullptr;
+    return chain;
+  }
+
+  /**
+   * detach the first count nodes (all of them if fewer) in O(count),
+   * returning them as one null terminated chain
+   */
+  node *cut_front(int count) {
+    if (count <= 0 || head == nullptr)
+      return nullptr;
+    if (count >= size)
+      return release();
+    node *last = head;
+    for (int i = 1; i < count; ++i)
+      last = last->next;
+    node *chain = head;
+    head = last->next;
+    head->prev = nullptr;
+    last->next = nullptr;
+    size -= count;
+    return chain;
   }
 };
 
@@ -449,26 +783,40 @@ public:
     hash_table.assign(capacity, -1);
     data.clear();
   }
+  // exchange contents in O(1)
+  void swap(hashmap &other) {
+    hash_table.swap(other.hash_table);
+    data.swap(other.data);
+    std::swap(size, other.size);
+    std::swap(capacity, other.capacity);
+  }
   /**
    * you need to expand the hashmap dynamically
    */
-  void expand() {
-    capacity *= 2;
+  void expand() { rehash(capacity * 2); }
 
-    std::vector<int> new_hash_table(capacity, -1);
-    std::vector<node> new_data;
-    new_data.reserve(data.size()); // 预分配空间，避免不必要的重新分配
+  void rehash(int new_capacity) {
+    capacity = new_capacity;
 
-    // 重新分配节点
-    for (node &n : data) {
-      size_t new_idx = Hash()(n.kv.first) % capacity;
-      new_data.push_back(std::move(n));
-      new_hash_table[new_idx] = new_data.size() - 1;
+    // 节点在 data 中的位置不变，只需重新串起每个桶的链
+    hash_table.assign(capacity, -1);
+    for (int i = 0; i < (int)data.size(); ++i) {
+      size_t idx = get_index(data[i].kv.first);
+      data[i].next = hash_table[idx];
+      hash_table[idx] = i;
     }
+  }
 
-    // 更新哈希表
-    hash_table = std::move(new_hash_table);
-    data = std::move(new_data);
+  /**
+   * make room for count elements so that inserting them never expands
+   */
+  void reserve(size_t count) {
+    int need = capacity;
+    while (count >= need * LOAD_FACTOR)
+      need *= 2;
+    data.reserve(count);
+    if (need != capacity)
+      rehash(need);
   }
 
   // return the end()
@@ -510,7 +858,10 @@ public:
 
     while (*ptr != -1) {
       if (Equal()(data[*ptr].kv.first, key)) {
-        *ptr = data[*ptr].next;
+        int hole = *ptr;
+        *ptr = data[hole].next;
+        fill_hole(hole);
+        size--;
         return true;
       }
       ptr = &data[*ptr].next;
@@ -518,6 +869,25 @@ public:
 
     return false;
   }
+
+private:
+  /**
+   * keep data dense: move the last node into the slot just unlinked,
+   * then redirect whatever pointed at the last node
+   */
+  void fill_hole(int hole) {
+    int last = data.size() - 1;
+    if (hole != last) {
+      int *ptr = &hash_table[get_index(data[last].kv.first)];
+      while (*ptr != last)
+        ptr = &data[*ptr].next;
+      *ptr = hole;
+      // kv 的 key 是 const，只能原地重新构造
+      data[hole].~node();
+      new (&data[hole]) node(data[last]);
+    }
+    data.pop_back();
+  }
 };
 
 template <class Key, class T, class Hash = std::hash<Key>,
@@ -529,14 +899,18 @@ public:
   // using iterator of double_list
   using iterator = typename double_list<value_type>::iterator;
   using const_iterator = typename double_list<value_type>::const_iterator;
+  using reclaimer = sjtu::reclaimer;
 
 private:
   double_list<value_type> dl;
   hashmap<Key, iterator, Hash, Equal> mapp; // 存储 {key, 对应链表迭代器}
+  stats_counter counter;
+  reclaimer *rec = nullptr; // 不为空时删除的节点交给它释放
 
 public:
   linked_hashmap() {};
-  linked_hashmap(const linked_hashmap &other) : mapp(other.mapp) {
+  linked_hashmap(const linked_hashmap &other)
+      : mapp(other.mapp), counter(other.counter) {
     for (auto it = other.dl.cbegin(); it != other.dl.cend(); ++it)
       dl.insert_tail(*it);
   }
@@ -545,10 +919,21 @@ public:
       clear();
       for (auto it = other.dl.cbegin(); it != other.dl.cend(); ++it)
         insert(*it);
+      counter = other.counter;
     }
     return *this;
   }
-  ~linked_hashmap() { clear(); }
+  ~linked_hashmap() {
+    rec = nullptr;
+    clear();
+  }
+
+  /**
+   * hand removed and cleared nodes to r instead of deleting them,
+   * nullptr restores inline deletion. r is not owned nor copied, and the
+   * destructor always deletes inline.
+   */
+  void set_reclaimer(reclaimer *r) { rec = r; }
 
   T &at(const Key &key) {
     auto it = mapp.find(key);
@@ -577,21 +962,33 @@ public:
 
   bool empty() const { return dl.empty(); }
   size_t size() const { return dl.size; }
+  // presize the index before a bulk insert
+  void reserve(size_t count) { mapp.reserve(count); }
 
   void clear() {
-    dl.clear();
+    if (rec)
+      rec->retire_chain(dl.release());
+    else
+      dl.clear();
     mapp.clear();
+    counter.clear();
   }
   // similar to previous function
   sjtu::pair<iterator, bool> insert(const value_type &value) {
     auto it = mapp.find(value.first);
     if (it != mapp.end()) {
-      dl.erase(it->second);
+      counter.update(value_bytes(it->second->second),
+                     value_bytes(value.second));
+      if (rec)
+        rec->retire_chain(dl.unlink(it->second));
+      else
+        dl.erase(it->second);
       dl.insert_tail(value);
       auto new_pos = dl.get_tail();
       it->second = new_pos;
       return {iterator(new_pos), false};
     } else {
+      counter.insert(value_bytes(value.second));
       dl.insert_tail(value);
       auto lit = dl.get_tail();
       mapp.insert({value.first, lit});
@@ -602,8 +999,66 @@ public:
   void remove(iterator pos) {
     if (pos == end())
       throw std::out_of_range("Iterator out of range");
+    counter.evict(value_bytes(pos->second));
     mapp.remove(pos->first);
-    dl.erase(pos);
+    if (rec)
+      rec->retire_chain(dl.unlink(pos));
+    else
+      dl.erase(pos);
+  }
+
+  /**
+   * remove the count oldest entries at once, calling f(key, value) on each
+   * first. the nodes are unlinked as a single chain and freed (or retired)
+   * in one sweep; when most of the map goes the index is rebuilt from the
+   * survivors instead of being updated key by key.
+   */
+  template <class F> void remove_front(size_t count, F f) {
+    if (count == 0 || empty())
+      return;
+    if (count >= size()) {
+      for (auto it = begin(); it != end(); ++it) {
+        counter.evict(value_bytes(it->second));
+        f(it->first, it->second);
+      }
+      clear();
+      return;
+    }
+    auto *chain = dl.cut_front(count);
+    for (auto *p = chain; p != nullptr; p = p->next) {
+      counter.evict(value_bytes(p->val.second));
+      f(p->val.first, p->val.second);
+    }
+    if (count * 2 >= size() + count) {
+      mapp.clear();
+      mapp.reserve(size());
+      for (auto it = begin(); it != end(); ++it)
+        mapp.insert({it->first, it});
+    } else {
+      for (auto *p = chain; p != nullptr; p = p->next)
+        mapp.remove(p->val.first);
+    }
+    if (rec)
+      rec->retire_chain(chain);
+    else
+      dl.free_chain(chain);
+  }
+
+  // mark pos as the most recently inserted, O(1) and no copy
+  void move_to_back(iterator pos) { dl.move_to_tail(pos); }
+
+  /**
+   * move the entry at pos of from (whose keys must not be in this map)
+   * to the back of this map, relinking its node instead of copying it
+   */
+  void splice_back(linked_hashmap &from, iterator pos) {
+    size_t b = value_bytes(pos->second);
+    from.counter.evict(b);
+    from.mapp.remove(pos->first);
+    dl.link_tail(from.dl.unlink(pos));
+    auto lit = dl.get_tail();
+    counter.insert(b);
+    mapp.insert({lit->first, lit});
   }
 
   size_t count(const Key &key) {
@@ -613,57 +1068,1659 @@ public:
     return 1;
   }
   iterator find(const Key &key) {
+    iterator it = peek(key);
+    if (it == end())
+      counter.miss();
+    else
+      counter.hit();
+    return it;
+  }
+  // find without counting a hit or miss, for the owner's own bookkeeping
+  iterator peek(const Key &key) {
     auto it = mapp.find(key);
-    return it != mapp.end() ? it->second : end();
+    return it == mapp.end() ? end() : it->second;
+  }
+
+  cache_stats stats() const { return counter.snapshot(); }
+  void reset_stats() { counter.reset(); }
+};
+
+/**
+ * hashes of the most recently evicted keys, without their values.
+ * a miss on a key still in here would have been a hit had the cache been
+ * up to capacity() entries larger.
+ */
+class ghost_list {
+  // (hash, seq) in eviction order, oldest at head
+  std::vector<pair<uint64_t, uint64_t>> ring;
+  size_t head = 0;
+  size_t count = 0;
+  uint64_t seq = 0;
+  // hash -> seq of its latest eviction, older ring slots are stale
+  hashmap<uint64_t, uint64_t> index;
+
+public:
+  explicit ghost_list(size_t cap) : ring(cap) { index.reserve(cap); }
+
+  size_t capacity() const { return ring.size(); }
+
+  void push(uint64_t hash) {
+    if (ring.empty())
+      return;
+    if (count == ring.size()) {
+      const pair<uint64_t, uint64_t> &old = ring[head];
+      auto it = index.find(old.first);
+      if (it != index.end() && it->second == old.second)
+        index.remove(old.first);
+      head = (head + 1) % ring.size();
+      --count;
+    }
+    ring[(head + count) % ring.size()] = pair<uint64_t, uint64_t>(hash, ++seq);
+    ++count;
+    index.insert(pair<const uint64_t, uint64_t>(hash, seq));
+  }
+
+  /**
+   * forget hash, return whether it was a ghost
+   */
+  bool take(uint64_t hash) { return index.remove(hash); }
+
+  void clear() {
+    head = count = 0;
+    index.clear();
+  }
+};
+
+/**
+ * lossy striped buffers of the keys hit under the shared lock.
+ * readers append to the stripe picked by their thread id with one CAS and
+ * never block: a record is dropped when its stripe is full or contended.
+ * the thread holding the exclusive lock drains every stripe and replays
+ * the hits onto the recency list, so a dropped record only makes the
+ * order slightly less exact.
+ */
+class read_buffer {
+  static constexpr size_t STRIPES = 16;
+  static constexpr uint32_t SLOTS = 64;
+  static constexpr int64_t EMPTY_SLOT = INT64_MIN;
+
+  // 每个 stripe 独占 cache line，避免不同线程之间伪共享
+  struct alignas(64) stripe {
+    std::atomic<uint32_t> reads{0};
+    std::atomic<uint32_t> writes{0};
+    std::atomic<int64_t> slots[SLOTS];
+    stripe() {
+      for (auto &s : slots)
+        s.store(EMPTY_SLOT, std::memory_order_relaxed);
+    }
+  };
+  stripe stripes[STRIPES];
+
+  static size_t stripe_index() {
+    static thread_local size_t idx =
+        std::hash<std::thread::id>()(std::this_thread::get_id()) % STRIPES;
+    return idx;
+  }
+
+public:
+  /**
+   * return true once the stripe is half full and should be drained
+   */
+  bool record(int key) {
+    stripe &s = stripes[stripe_index()];
+    uint32_t w = s.writes.load(std::memory_order_relaxed);
+    uint32_t r = s.reads.load(std::memory_order_acquire);
+    if (w - r >= SLOTS)
+      return true;
+    if (!s.writes.compare_exchange_weak(w, w + 1, std::memory_order_relaxed))
+      return false;
+    s.slots[w % SLOTS].store(key, std::memory_order_release);
+    return w + 1 - r >= SLOTS / 2;
+  }
+
+  /**
+   * hand every published record to f, only one thread may drain at a time
+   */
+  template <class F> void drain(F f) {
+    for (stripe &s : stripes) {
+      uint32_t r = s.reads.load(std::memory_order_relaxed);
+      uint32_t w = s.writes.load(std::memory_order_acquire);
+      for (; r != w; ++r) {
+        std::atomic<int64_t> &slot = s.slots[r % SLOTS];
+        int64_t key = slot.load(std::memory_order_acquire);
+        if (key == EMPTY_SLOT)
+          break; // 槽位已被占用但还没写入，下次再取
+        slot.store(EMPTY_SLOT, std::memory_order_relaxed);
+        f((int)key);
+      }
+      s.reads.store(r, std::memory_order_release);
+    }
+  }
+};
+
+/**
+ * second cache tier: values evicted from an lru are appended to a shared
+ * file mapping, with only (offset, shape) per key kept in memory.
+ * taking a value back out leaves a dead record behind; when the segment
+ * is full it is rewritten with the live records only, doubling its size
+ * if they fill more than half of it. the file is deleted on destruction.
+ */
+class spill_tier {
+  // 记录头，后面紧跟 rows * cols 个 int，整体按 8 字节对齐
+  struct record {
+    int64_t key;
+    uint64_t rows;
+    uint64_t cols;
+  };
+  struct location {
+    uint64_t offset;
+    uint64_t bytes;
+  };
+
+  std::string path;
+  mapped_segment seg;
+  hashmap<Integer, location, Hash, Equal> index;
+  uint64_t tail = 0; // 下一条记录写入的位置
+  uint64_t live = 0; // 仍被索引引用的字节数
+
+  // segments are never smaller than a page, so there is always room to double
+  static uint64_t page_bytes() {
+    long page = sysconf(_SC_PAGESIZE);
+    return page > 0 ? (uint64_t)page : 4096;
+  }
+
+  static uint64_t record_bytes(const Matrix<int> &mat) {
+    uint64_t body = mat.RowSize() * mat.ColSize() * sizeof(int);
+    return (sizeof(record) + body + 7) / 8 * 8;
+  }
+
+  /**
+   * copy the live records into a new segment of the given size. the
+   * index keeps the old offsets until the new file has replaced the old
+   * one, so a failure leaves the tier as it was
+   */
+  bool rewrite(uint64_t bytes) {
+    std::string tmp = path + ".compact";
+    mapped_segment next;
+    if (!next.create(tmp.c_str(), bytes))
+      return false;
+    std::vector<uint64_t> moved;
+    moved.reserve(index.data.size());
+    uint64_t pos = 0;
+    for (auto &node : index.data) {
+      const location &loc = node.kv.second;
+      std::memcpy(next.data() + pos, seg.data() + loc.offset, loc.bytes);
+      moved.push_back(pos);
+      pos += loc.bytes;
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+      std::remove(tmp.c_str());
+      return false;
+    }
+    seg.swap(next);
+    size_t i = 0;
+    for (auto &node : index.data)
+      node.kv.second.offset = moved[i++];
+    tail = pos;
+    return true;
+  }
+
+public:
+  explicit spill_tier(const std::string &path,
+                      uint64_t segment_bytes = 64 << 20)
+      : path(path) {
+    seg.create(path.c_str(), std::max(segment_bytes, page_bytes()));
+  }
+  spill_tier(const spill_tier &) = delete;
+  spill_tier &operator=(const spill_tier &) = delete;
+  ~spill_tier() {
+    seg.close();
+    std::remove(path.c_str());
+  }
+
+  bool ok() const { return seg.is_open(); }
+  size_t size() const { return index.size; }
+  uint64_t live_bytes() const { return live; }
+  uint64_t file_bytes() const { return seg.size(); }
+
+  /**
+   * store a copy of mat under key, replacing any older copy.
+   * return false if the segment could not be grown
+   */
+  bool put(const Integer &key, const Matrix<int> &mat) {
+    if (!ok())
+      return false;
+    erase(key);
+    uint64_t bytes = record_bytes(mat);
+    if (tail + bytes > seg.size()) {
+      uint64_t need = std::max<uint64_t>(seg.size(), page_bytes());
+      while (live + bytes > need / 2)
+        need *= 2;
+      if (!rewrite(need))
+        return false;
+    }
+
+    char *p = seg.data() + tail;
+    record head = {key.val, mat.RowSize(), mat.ColSize()};
+    std::memcpy(p, &head, sizeof(head));
+    p += sizeof(head);
+    if (mat.size() > 0)
+      std::memcpy(p, mat.data(), mat.size() * sizeof(int));
+    index.insert(
+        pair<const Integer, location>(key, location{tail, bytes}));
+    tail += bytes;
+    live += bytes;
+    return true;
+  }
+
+  /**
+   * move the value of key into out, return false if it is not stored
+   */
+  bool take(const Integer &key, Matrix<int> &out) {
+    auto it = index.find(key);
+    if (it == index.end())
+      return false;
+    const char *p = seg.data() + it->second.offset;
+    record head;
+    std::memcpy(&head, p, sizeof(head));
+    p += sizeof(head);
+    out = Matrix<int>(head.rows, head.cols);
+    if (out.size() > 0)
+      std::memcpy(out.data(), p, out.size() * sizeof(int));
+    erase(key);
+    return true;
+  }
+
+  void erase(const Integer &key) {
+    auto it = index.find(key);
+    if (it == index.end())
+      return;
+    live -= it->second.bytes;
+    index.remove(key);
+  }
+
+  // reclaim the space of the dead records now
+  bool compact() { return ok() && rewrite(seg.size()); }
+
+  // forget every record; a non-null r frees the old index later
+  void clear(reclaimer *r = nullptr) {
+    if (r) {
+      auto *old = new hashmap<Integer, location, Hash, Equal>();
+      old->swap(index);
+      r->retire(old);
+    } else {
+      index.clear();
+    }
+    tail = live = 0;
   }
 };
 
-class lru {
-  using lmap = sjtu::linked_hashmap<Integer, Matrix<int>, Hash, Equal>;
-  using value_type = sjtu::pair<const Integer, Matrix<int>>;
+/**
+ * per-thread direct-mapped front cache of weak handles to values of the
+ * basic_lru<V> instances. a slot is only trusted while the owner's generation and the
+ * version stripe of its key still hold the numbers seen when it was
+ * filled; the owner bumps them under its exclusive lock whenever a key is
+ * saved, evicted or cleared. a hit therefore reads only this thread's slot
+ * and two read-mostly counters, and never a stale value. being weak, a
+ * slot never keeps an evicted value alive, even in a thread that stays
+ * idle: only the value's small handle_box lingers until the slot is reused.
+ */
+template <class V> class front_cache {
+public:
+  static constexpr size_t SLOTS = 64;
+  static constexpr size_t VERSION_STRIPES = 4096;
+
+  struct slot {
+    uint64_t owner = 0; // lru id, 0 = empty
+    int key = 0;
+    uint64_t generation = 0;
+    uint64_t version = 0;
+    weak_handle<V> val;
+  };
+
+  static slot &at(uint64_t key_hash) {
+    static thread_local slot slots[SLOTS];
+    return slots[mix_hash(key_hash) % SLOTS];
+  }
+};
+
+// who frees the nodes an lru evicts or clears
+enum class reclaim_mode { inline_free, manual, background };
+
+/**
+ * map from Integer to V that keeps at most n entries, evicting the least
+ * recently used one. every public member takes the cache's own
+ * std::shared_mutex (exclusively, except buffered get hits and front
+ * cache hits), so an instance can be shared between threads as is; a
+ * single-threaded caller pays one uncontended lock per call.
+ *
+ * a trivially copyable V of at most INLINE_BYTES, such as FixedMatrix,
+ * is stored in the node itself (see inline_cell) and costs no allocation
+ * until get_handle, interning or the front cache needs to share it; any
+ * other V is kept in a value_handle, one allocation per entry.
+ * V only has to be copyable; value_bytes(V) weighs it in stats() and
+ * interning needs Fingerprint(V) and ==. compression, the spill tier and
+ * dump / load store the elements of a Matrix<int> and only compile for
+ * lru, print() needs operator<< for V.
+ */
+template <class V> class basic_lru {
+public:
+  // read-only: with interning one value can be shared by several keys
+  using handle = value_handle<const V>;
+
+private:
+  static constexpr size_t INLINE_BYTES = 256;
+  static constexpr bool INLINE =
+      std::is_trivially_copyable<V>::value && sizeof(V) <= INLINE_BYTES;
+  // 节点里存的是句柄，淘汰后仍被持有的值不会被释放；小值直接放在节点里
+  using cell = typename std::conditional<INLINE, inline_cell<V>,
+                                         value_handle<V>>::type;
+  using lmap = sjtu::linked_hashmap<Integer, cell, Hash, Equal>;
+  using value_type = sjtu::pair<const Integer, V>;
+  using cold_map =
+      sjtu::linked_hashmap<Integer, packed_matrix<int>, Hash, Equal>;
+  using front = front_cache<V>;
+  // whether the Matrix<int> only tiers (cold, spill, snapshots) can be used
+  static constexpr bool PACKABLE = std::is_same<V, Matrix<int>>::value;
+
+private:
+  /**
+   * one in-flight get_or_compute miss, shared by every caller asking
+   * for the same key until the loader returns
+   */
+  struct flight {
+    Integer key;
+    bool done = false;
+    V val;
+    std::exception_ptr err;
+    std::condition_variable_any cv;
+    flight(const Integer &key) : key(key) {}
+  };
+
+  static constexpr const char *SNAPSHOT_MAGIC = "SJLRU\x00\x00\x02";
+  // i32 key, i32 class, u64 rows, u64 cols
+  static constexpr size_t RECORD_HEADER = 24;
+
+public:
+  static constexpr int PRIORITY_LEVELS = 4;
+  // the class for_each_locked and snapshots give pinned entries
+  static constexpr int PINNED_CLASS = -1;
 
 private:
   int n;
   lmap lhm;
+  // 缓冲模式下 get 命中只取共享锁，其余操作都取独占锁
+  std::shared_mutex mtx;
+  stats_counter counter;
+  // 正在计算中的 key，数量不超过并发线程数，线性查找即可
+  std::vector<std::shared_ptr<flight>> flights;
+  std::unique_ptr<mrc_analyser> mrc; // 默认关闭
+  std::atomic<bool> sampling{false};  // mrc 开启时 front cache 不能跳过采样
+  std::unique_ptr<ghost_list> ghosts; // 默认关闭
+  size_t ghost_hits = 0;
+  // 默认关闭; front cache 开启后不再释放，无锁命中也会写入
+  std::unique_ptr<read_buffer> reads;
+  std::atomic<bool> buffered{false};
+  // 默认就地释放; reclaim() 解锁后仍持有一份引用
+  std::shared_ptr<reclaimer> rec;
+  std::unique_ptr<spill_tier> spill;    // 默认关闭
+  // 压缩模式下 lhm 只保留最近的 hot 个条目，更冷的压缩后放在 cold
+  std::unique_ptr<cold_map> cold;
+  int hot = 0;
+  // 优先级 1..PRIORITY_LEVELS-1 的条目各自一条链表，0 级就是 lhm/cold
+  std::unique_ptr<lmap> levels[PRIORITY_LEVELS];
+  // 被钉住的条目不参与淘汰
+  lmap pinned;
+  int pin_limit;
+  // front cache 用到的失效计数，开启后不再释放
+  const uint64_t id = new_id();
+  std::atomic<bool> fronted{false};
+  std::atomic<uint64_t> generation{1};
+  std::unique_ptr<std::atomic<uint64_t>[]> versions;
+  // 记录所有在内存中的 key，开启后同样不再释放
+  std::unique_ptr<counting_bloom> filter;
+  std::atomic<bool> filtered{false};
+  // a filtered miss can skip the lock: no mrc, ghost or spill bookkeeping
+  std::atomic<bool> quick_miss{false};
+  // 相同内容的值只存一份，默认关闭
+  std::unique_ptr<intern_pool<V>> pool;
+  // interning 开着时值可能被共享，get 不返回可写指针
+  std::atomic<bool> shared_values{false};
+
+  static uint64_t new_id() {
+    static std::atomic<uint64_t> next{1};
+    return next.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // key's value changed or left the cache, front cache copies are stale
+  void invalidate_locked(const Integer &key) {
+    if (versions)
+      versions[Hash()(key) % front::VERSION_STRIPES].fetch_add(
+          1, std::memory_order_release);
+  }
+
+  // share a value just read under the lock with this thread's front slot.
+  // a value still inline in its node is not shared: that would allocate
+  void fill_front(const Integer &key, const cell &val) {
+    if constexpr (INLINE) {
+      if (!val.shared())
+        return;
+    }
+    typename front::slot &s = front::at(Hash()(key));
+    s.owner = id;
+    s.key = key.val;
+    s.generation = generation.load(std::memory_order_relaxed);
+    s.version = versions[Hash()(key) % front::VERSION_STRIPES].load(
+        std::memory_order_relaxed);
+    s.val = boxed(val);
+  }
+
+  static const value_handle<V> &boxed(const value_handle<V> &val) {
+    return val;
+  }
+  static const value_handle<V> &boxed(const inline_cell<V> &val) {
+    return val.handle();
+  }
+  // the value as a shared handle, boxing an inline one (exclusive lock)
+  static const value_handle<V> &share(value_handle<V> &val) { return val; }
+  static const value_handle<V> &share(inline_cell<V> &val) {
+    return val.share();
+  }
+
+  /**
+   * keep val alive for the calling thread until its next get, so the
+   * pointer get returns survives another thread replacing or evicting it.
+   * a value inline in its node is returned in place
+   */
+  static V *hold(const value_handle<V> &val) {
+    static thread_local value_handle<V> held;
+    held = val;
+    return held.get();
+  }
+  static V *hold(inline_cell<V> &val) {
+    if (!val.shared())
+      return val.get();
+    return hold(val.handle());
+  }
+
+  void update_quick_miss_locked() {
+    quick_miss.store(filtered.load(std::memory_order_relaxed) && !mrc &&
+                         !ghosts && !spill,
+                     std::memory_order_release);
+  }
+
+  // true if key is surely not in memory
+  bool filtered_out(const Integer &key) const {
+    return filtered.load(std::memory_order_acquire) &&
+           !filter->may_contain(Hash()(key));
+  }
+
+  // the handle to store for mat, shared with an equal value when interning
+  cell stored(const V &val) {
+    return pool ? pool->intern(val) : cell(val);
+  }
+
+  static const V &unpacked(const cell &val) { return *val; }
+  static Matrix<int> unpacked(const packed_matrix<int> &val) {
+    return val.unpack();
+  }
+
+  size_t entries() const {
+    size_t res = lhm.size() + pinned.size() + (cold ? cold->size() : 0);
+    for (int l = 1; l < PRIORITY_LEVELS; ++l)
+      res += levels[l] ? levels[l]->size() : 0;
+    return res;
+  }
+
+  lmap &level_map(int level) {
+    if (level <= 0)
+      return lhm;
+    if (level >= PRIORITY_LEVELS)
+      level = PRIORITY_LEVELS - 1;
+    if (!levels[level]) {
+      levels[level].reset(new lmap());
+      levels[level]->set_reclaimer(rec.get());
+    }
+    return *levels[level];
+  }
+
+  // the map holding key among the priority levels and pinned, or nullptr
+  lmap *other_owner(const Integer &key) {
+    for (int l = 1; l < PRIORITY_LEVELS; ++l) {
+      if (levels[l] && !levels[l]->empty() && levels[l]->count(key))
+        return levels[l].get();
+    }
+    if (!pinned.empty() && pinned.count(key))
+      return &pinned;
+    return nullptr;
+  }
+
+  // move what no longer fits in the hot part to the cold end, packed
+  void demote_locked() {
+    if constexpr (PACKABLE) {
+      while (cold && (int)lhm.size() > hot) {
+        auto victim = lhm.begin();
+        packed_matrix<int> packed(*victim->second);
+        counter.adjust(value_bytes(victim->second), value_bytes(packed));
+        cold->insert(cold_map::value_type(victim->first, packed));
+        lhm.remove(victim);
+      }
+    }
+  }
+
+  /**
+   * move the entry of key, wherever it is, to the back of to.
+   * return nullptr if key is not cached
+   */
+  cell *move_locked(const Integer &key, lmap &to) {
+    lmap *from = lhm.count(key) ? &lhm : other_owner(key);
+    if (from == &to) {
+      auto it = to.peek(key);
+      to.move_to_back(it);
+      return &(it->second);
+    }
+    if (from) {
+      to.splice_back(*from, from->peek(key));
+    } else if (!cold || !cold->count(key)) {
+      return nullptr;
+    } else if constexpr (PACKABLE) {
+      auto packed = cold->peek(key);
+      Matrix<int> mat = packed->second.unpack();
+      counter.adjust(value_bytes(packed->second), value_bytes(mat));
+      cold->remove(packed);
+      to.insert(typename lmap::value_type(key, stored(mat)));
+    }
+    cell *res = &(to.peek(key)->second);
+    demote_locked(); // to 是 lhm 时可能超出热区
+    return res;
+  }
+
+  void clear_locked() {
+    generation.fetch_add(1, std::memory_order_release);
+    lhm.clear();
+    if (cold)
+      cold->clear();
+    for (int l = 1; l < PRIORITY_LEVELS; ++l) {
+      if (levels[l])
+        levels[l]->clear();
+    }
+    pinned.clear();
+    counter.clear();
+    if (filter)
+      filter->clear();
+  }
+
+  /**
+   * visit every entry as f(key, value, class), each part from least to
+   * most recently used: cold and class 0, the higher classes, then the
+   * pinned entries (PINNED_CLASS)
+   */
+  template <class F> void for_each_locked(F f) {
+    if constexpr (PACKABLE) {
+      if (cold) {
+        for (auto it = cold->begin(); it != cold->end(); ++it)
+          f(it->first, it->second.unpack(), 0);
+      }
+    }
+    for (auto it = lhm.begin(); it != lhm.end(); ++it)
+      f(it->first, *it->second, 0);
+    for (int l = 1; l < PRIORITY_LEVELS; ++l) {
+      if (!levels[l])
+        continue;
+      for (auto it = levels[l]->begin(); it != levels[l]->end(); ++it)
+        f(it->first, *it->second, l);
+    }
+    for (auto it = pinned.begin(); it != pinned.end(); ++it)
+      f(it->first, *it->second, PINNED_CLASS);
+  }
+
+  // replay buffered hits, caller holds the exclusive lock
+  void drain_locked() {
+    if (!reads)
+      return;
+    reads->drain([this](int key) { touch_locked(Integer(key)); });
+  }
+
+  // a hit recorded without the exclusive lock: refresh key's recency
+  void touch_locked(const Integer &key) {
+    auto it = lhm.peek(key);
+    if (it != lhm.end()) {
+      lhm.move_to_back(it);
+    } else if (lmap *owner = other_owner(key)) {
+      owner->move_to_back(owner->peek(key));
+    } else if (cold && cold->count(key)) {
+      move_locked(key, lhm);
+    }
+  }
+
+  /**
+   * the value in this thread's front slot for v if it is still current and
+   * alive, empty otherwise. the hit is counted and queued for replay into
+   * the recency order
+   */
+  value_handle<V> front_hit(const Integer &v) {
+    if (!fronted.load(std::memory_order_acquire) ||
+        sampling.load(std::memory_order_acquire))
+      return value_handle<V>();
+    unsigned int h = Hash()(v);
+    typename front::slot &s = front::at(h);
+    if (s.owner != id || s.key != v.val ||
+        s.generation != generation.load(std::memory_order_acquire) ||
+        s.version != versions[h % front::VERSION_STRIPES].load(
+                         std::memory_order_acquire))
+      return value_handle<V>();
+    value_handle<V> res = s.val.lock();
+    if (!res)
+      return res; // 刚被淘汰
+    counter.hit();
+    if (reads->record(v.val)) {
+      std::unique_lock<std::shared_mutex> writer(mtx, std::try_to_lock);
+      if (writer)
+        drain_locked();
+    }
+    return res;
+  }
+
+  std::unique_lock<std::shared_mutex> acquire() {
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    drain_locked();
+    return lock;
+  }
+
+  /**
+   * 删除最久未使用的: cold first, then the lowest non-empty priority
+   * level. pinned entries are never chosen. return false if nothing
+   * can be evicted
+   */
+  bool evict_locked() {
+    if (cold && !cold->empty()) {
+      auto victim = cold->begin();
+      counter.evict(value_bytes(victim->second));
+      if (ghosts)
+        ghosts->push(Hash()(victim->first));
+      if (spill)
+        spill->put(victim->first, victim->second.unpack());
+      invalidate_locked(victim->first);
+      if (filter)
+        filter->remove(Hash()(victim->first));
+      cold->remove(victim);
+      return true;
+    }
+    lmap *from = nullptr;
+    for (int l = 0; l < PRIORITY_LEVELS && from == nullptr; ++l) {
+      lmap *m = l == 0 ? &lhm : levels[l].get();
+      if (m && !m->empty())
+        from = m;
+    }
+    if (from == nullptr)
+      return false;
+    auto victim = from->begin();
+    counter.evict(value_bytes(victim->second));
+    if (ghosts)
+      ghosts->push(Hash()(victim->first));
+    if constexpr (PACKABLE) {
+      if (spill)
+        spill->put(victim->first, *victim->second);
+    }
+    invalidate_locked(victim->first);
+    if (filter)
+      filter->remove(Hash()(victim->first));
+    from->remove(victim);
+    return true;
+  }
+
+  /**
+   * evict up to count entries in eviction order, taking each part's
+   * oldest entries in one remove_front sweep. return how many went
+   */
+  size_t evict_bulk_locked(size_t count) {
+    size_t done = 0;
+    auto gone = [this](const Integer &key, const auto &val) {
+      counter.evict(value_bytes(val));
+      if (ghosts)
+        ghosts->push(Hash()(key));
+      if constexpr (PACKABLE) {
+        if (spill)
+          spill->put(key, unpacked(val));
+      }
+      invalidate_locked(key);
+      if (filter)
+        filter->remove(Hash()(key));
+    };
+    if (cold) {
+      size_t k = std::min(count, cold->size());
+      cold->remove_front(k, gone);
+      done += k;
+    }
+    for (int l = 0; l < PRIORITY_LEVELS && done < count; ++l) {
+      lmap *m = l == 0 ? &lhm : levels[l].get();
+      if (m == nullptr)
+        continue;
+      size_t k = std::min(count - done, m->size());
+      m->remove_front(k, gone);
+      done += k;
+    }
+    return done;
+  }
+
+  /**
+   * level < 0 keeps the class of an existing entry (level 0 for a new
+   * one); a pinned entry stays pinned
+   */
+  void save_locked(const value_type &v, int level = -1) {
+    invalidate_locked(v.first);
+    lmap *to = &level_map(level);
+    auto it = lhm.peek(v.first);
+    if (it != lhm.end()) {
+      counter.update(value_bytes(it->second), value_bytes(v.second));
+      lhm.remove(it); // 先删除旧的，再插入新的
+    } else if (cold && cold->count(v.first)) {
+      auto old = cold->peek(v.first);
+      counter.update(value_bytes(old->second), value_bytes(v.second));
+      cold->remove(old);
+    } else if (lmap *owner = other_owner(v.first)) {
+      auto old = owner->peek(v.first);
+      counter.update(value_bytes(old->second), value_bytes(v.second));
+      owner->remove(old);
+      if (level < 0 || owner == &pinned)
+        to = owner;
+    } else {
+      if ((int)entries() >= n)
+        evict_locked(); // 容量满了
+      if (ghosts)
+        ghosts->take(Hash()(v.first));
+      if (spill)
+        spill->erase(v.first); // 内存中的新值优先，丢弃旧副本
+      if (filter)
+        filter->add(Hash()(v.first));
+      counter.insert(value_bytes(v.second));
+    }
+    to->insert(typename lmap::value_type(v.first, stored(v.second))); // 插入到链表尾部
+    demote_locked();
+  }
+
+  /**
+   * the entry of key wherever it is cached, brought back from the cold
+   * or spill tier if need be, without counting a hit or a miss
+   */
+  cell *find_locked(const Integer &key) {
+    auto it = lhm.peek(key);
+    if (it != lhm.end())
+      return &(it->second);
+    lmap *owner = other_owner(key);
+    if (owner != nullptr || (cold && cold->count(key)))
+      return move_locked(key, owner ? *owner : lhm);
+    if constexpr (PACKABLE) {
+      Matrix<int> promoted;
+      if (spill && spill->take(key, promoted)) {
+        save_locked(value_type(key, promoted));
+        return &(lhm.peek(key)->second);
+      }
+    }
+    return nullptr;
+  }
+
+  cell *get_locked(const Integer &v) {
+    if (mrc)
+      mrc->access(Hash()(v));
+    if (!filtered_out(v)) {
+      auto it = lhm.peek(v);
+      if (it != lhm.end()) {
+        counter.hit();
+        lhm.move_to_back(it); // 移到链表尾部(最近使用)
+        return &(it->second);
+      }
+      lmap *owner = other_owner(v);
+      if (owner != nullptr || (cold && cold->count(v))) {
+        counter.hit();
+        return move_locked(v, owner ? *owner : lhm);
+      }
+    }
+
+    if (ghosts && ghosts->take(Hash()(v)))
+      ++ghost_hits;
+    if constexpr (PACKABLE) {
+      Matrix<int> promoted;
+      if (spill && spill->take(v, promoted)) {
+        // 从第二层取回也是命中；重新放回内存照常计一次 insert
+        counter.hit();
+        save_locked(value_type(v, promoted));
+        return &(lhm.peek(v)->second);
+      }
+    }
+    counter.miss();
+    return nullptr;
+  }
 
 public:
-  lru(int size) : n(size) {}
-  ~lru() {}
+  basic_lru(int size) : n(size), pin_limit(size / 2) {}
+  ~basic_lru() {}
   /**
    * save the value_pair in the memory
    * delete something in the memory if necessary
    */
   void save(const value_type &v) {
-    auto it = lhm.find(v.first);
-    if (it != lhm.end()) {
-      lhm.remove(it); // 先删除旧的，再插入新的
-    } else if (lhm.size() >= n) {
-      lhm.remove(lhm.begin()); // 容量满了，删除最久未使用的(链表头部)
-    }
-    lhm.insert(v); // 插入到链表头部
+    auto lock = acquire();
+    save_locked(v);
+  }
+
+  /**
+   * save v in priority class level (0 .. PRIORITY_LEVELS - 1). eviction
+   * only takes from a class once every lower class is empty.
+   */
+  void save(const value_type &v, int level) {
+    auto lock = acquire();
+    save_locked(v, level < 0 ? 0 : level);
+  }
+
+  /**
+   * move a cached entry to another priority class, false if not cached.
+   * a pinned entry is left pinned
+   */
+  bool set_priority(const Integer &key, int level) {
+    auto lock = acquire();
+    if (!pinned.empty() && pinned.count(key))
+      return true;
+    return move_locked(key, level_map(level)) != nullptr;
+  }
+
+  /**
+   * exempt a cached entry from eviction. fails if it is not cached or
+   * the pin limit (default half the capacity) is reached, so the cache
+   * always keeps room for unpinned entries.
+   */
+  bool pin(const Integer &key) {
+    auto lock = acquire();
+    if (!pinned.empty() && pinned.count(key))
+      return true;
+    if ((int)pinned.size() >= pin_limit || (int)pinned.size() + 1 >= n)
+      return false;
+    return move_locked(key, pinned) != nullptr;
+  }
+
+  // make a pinned entry evictable again, as the newest of class 0
+  bool unpin(const Integer &key) {
+    auto lock = acquire();
+    if (pinned.empty() || !pinned.count(key))
+      return false;
+    move_locked(key, lhm);
+    return true;
+  }
+
+  void set_pin_limit(int limit) {
+    auto lock = acquire();
+    pin_limit = limit;
   }
 
   /**
-   * return a pointer contain the value
+   * return a pointer contain the value. the value stays alive until the
+   * calling thread's next get, even if another thread replaces or evicts
+   * it meanwhile; use get_handle for a handle that keeps it longer. a
+   * value stored inline (see INLINE) is returned in place instead and
+   * lives until its entry is saved over, evicted or cleared.
+   * while interning is on a value may be shared by several keys, so get
+   * throws std::logic_error and callers read through get_const or
+   * get_handle instead; disable_interning() makes get usable again
    */
 
-  Matrix<int> *get(const Integer &v) {
-    auto it = lhm.find(v);
-    if (it == lhm.end())
+  V *get(const Integer &v) {
+    if (shared_values.load(std::memory_order_acquire))
+      throw std::logic_error("get on an lru that shares values");
+    return lookup(v);
+  }
+
+  // like get, but read-only, so it also works with interning
+  const V *get_const(const Integer &v) { return lookup(v); }
+
+  /**
+   * like get, but the returned handle keeps the value alive after it is
+   * evicted or replaced, so it can be used without holding any lock. the
+   * value is read-only through it. empty if key is not cached
+   */
+  handle get_handle(const Integer &v) {
+    if (value_handle<V> hit = front_hit(v))
+      return hit;
+    if (quick_miss.load(std::memory_order_acquire) && filtered_out(v)) {
+      counter.miss();
+      return handle();
+    }
+    auto lock = acquire();
+    cell *res = get_locked(v);
+    return res ? handle(share(*res)) : handle();
+  }
+
+private:
+  V *lookup(const Integer &v) {
+    if (value_handle<V> hit = front_hit(v))
+      return hold(hit);
+    bool front = fronted.load(std::memory_order_acquire);
+    if (quick_miss.load(std::memory_order_acquire) && filtered_out(v)) {
+      counter.miss();
+      return nullptr;
+    }
+    if (buffered.load(std::memory_order_relaxed)) {
+      std::shared_lock<std::shared_mutex> lock(mtx);
+      auto it = lhm.peek(v);
+      if (reads && !mrc && it != lhm.end()) {
+        counter.hit();
+        V *res = hold(it->second);
+        if (front)
+          fill_front(v, it->second);
+        bool full = reads->record(v.val);
+        lock.unlock();
+        if (full) {
+          std::unique_lock<std::shared_mutex> writer(mtx, std::try_to_lock);
+          if (writer)
+            drain_locked();
+        }
+        return res;
+      }
+    }
+    auto lock = acquire();
+    cell *res = get_locked(v);
+    if (res == nullptr)
       return nullptr;
+    if (front)
+      fill_front(v, *res);
+    return hold(*res);
+  }
 
-    auto val = it->second;
-    lhm.remove(it);       // 先删除
-    lhm.insert({v, val}); // 再插入到链表头部
-    return &(lhm.find(v)->second);
+public:
+
+  /**
+   * serve repeated gets of hot keys from a small per-thread table of
+   * handles (see front_cache) without taking the cache lock. such hits are
+   * counted in stats() and queued in a read_buffer like buffered reads, so
+   * the key's recency is refreshed at the next exclusive lock (approximately
+   * under heavy load). while the mrc is sampling every get takes the lock.
+   */
+  void enable_front_cache() {
+    auto lock = acquire();
+    if (!versions) {
+      versions.reset(
+          new std::atomic<uint64_t>[front::VERSION_STRIPES]());
+    }
+    if (!reads)
+      reads.reset(new read_buffer());
+    generation.fetch_add(1, std::memory_order_release);
+    fronted.store(true, std::memory_order_release);
+  }
+  void disable_front_cache() {
+    auto lock = acquire();
+    fronted.store(false, std::memory_order_release);
   }
 
-  void print() {
+  /**
+   * answer gets of keys that are not in memory from a counting_bloom of
+   * the cached keys instead of probing the hash tables. with no mrc,
+   * ghost list or spill tier to update such a miss takes no lock at all.
+   * the filter is sized once, for the capacity at the first call, with
+   * bits_per_key 8-bit counters per key; later calls only switch it on.
+   */
+  void enable_negative_filter(size_t bits_per_key = 8) {
+    auto lock = acquire();
+    if (!filter) {
+      filter.reset(new counting_bloom(n, bits_per_key));
+      for_each_locked([this](const Integer &key, const V &, int) {
+        filter->add(Hash()(key));
+      });
+    }
+    filtered.store(true, std::memory_order_release);
+    update_quick_miss_locked();
+  }
+  void disable_negative_filter() {
+    auto lock = acquire();
+    filtered.store(false, std::memory_order_release);
+    update_quick_miss_locked();
+  }
+
+  /**
+   * in buffered mode a get hit only takes the shared lock, does the hash
+   * lookup and appends the key to a read_buffer; the recency list is
+   * updated in batches by the next thread taking the exclusive lock.
+   * the order becomes approximate under heavy load (records may be
+   * dropped), which is why it is off by default. writers may run
+   * alongside readers: a pointer from get stays valid as described there.
+   */
+  void set_buffered_reads(bool on) {
+    auto lock = acquire();
+    if (on && !reads)
+      reads.reset(new read_buffer());
+    else if (!on && !versions)
+      reads.reset(); // front cache 可能仍在无锁地写入
+    buffered.store(on, std::memory_order_relaxed);
+  }
+
+  /**
+   * return the cached value of key, computing it with loader(key) on a miss.
+   * concurrent misses on the same key run loader only once: the other
+   * callers block until it finishes and share its result (or its exception).
+   * the value is inserted once, unless key was saved while loader ran:
+   * then the saved value is kept and returned instead. a copy is returned
+   * since the cached node may be evicted as soon as the lock is released.
+   */
+  template <class Loader>
+  V get_or_compute(const Integer &key, Loader loader) {
+    auto lock = acquire();
+    if (cell *p = get_locked(key))
+      return **p;
+
+    for (auto &f : flights) {
+      if (Equal()(f->key, key)) {
+        std::shared_ptr<flight> fl = f;
+        fl->cv.wait(lock, [&fl] { return fl->done; });
+        if (fl->err)
+          std::rethrow_exception(fl->err);
+        return fl->val;
+      }
+    }
+
+    auto fl = std::make_shared<flight>(key);
+    flights.push_back(fl);
+    lock.unlock();
+    try {
+      fl->val = loader(key);
+    } catch (...) {
+      fl->err = std::current_exception();
+    }
+    lock.lock();
+
+    if (!fl->err) {
+      // a save() of key while the loader ran is newer than its result
+      if (cell *p = find_locked(key))
+        fl->val = **p;
+      else
+        save_locked(value_type(key, fl->val));
+    }
+    for (size_t i = 0; i < flights.size(); ++i) {
+      if (flights[i] == fl) {
+        flights[i] = flights.back();
+        flights.pop_back();
+        break;
+      }
+    }
+    fl->done = true;
+    fl->cv.notify_all();
+    if (fl->err)
+      std::rethrow_exception(fl->err);
+    return fl->val;
+  }
+
+  /**
+   * hit/miss/insert/update/eviction counts and cached payload bytes,
+   * readable without taking the cache lock
+   */
+  cache_stats stats() const { return counter.snapshot(); }
+  void reset_stats() { counter.reset(); }
+
+  /**
+   * start sampling the keys passed to get / get_or_compute, see
+   * mrc_analyser for the parameters. restarting drops the old curve.
+   */
+  void enable_mrc(double rate = 0.01, size_t max_samples = 8192,
+                  size_t max_capacity = 1 << 16, size_t buckets = 256) {
+    auto lock = acquire();
+    mrc.reset(new mrc_analyser(rate, max_samples, max_capacity, buckets));
+    sampling.store(true, std::memory_order_release);
+    update_quick_miss_locked();
+  }
+  void disable_mrc() {
+    auto lock = acquire();
+    mrc.reset();
+    sampling.store(false, std::memory_order_release);
+    update_quick_miss_locked();
+  }
+  /**
+   * estimated (capacity, hit ratio) pairs from the sampled traffic,
+   * empty if enable_mrc() was never called
+   */
+  std::vector<pair<size_t, double>> hit_ratio_curve() {
+    auto lock = acquire();
+    if (!mrc)
+      return {};
+    return mrc->curve();
+  }
+
+  /**
+   * remove every entry. with deferred reclaiming this is O(1) for the
+   * caller, the nodes are freed by reclaim() or the background thread.
+   */
+  void clear() {
+    auto lock = acquire();
+    clear_locked();
+    if (spill)
+      spill->clear(rec.get());
+  }
+
+  /**
+   * store equal values once: entries saved from now on share one
+   * refcounted copy with every other entry holding the same matrix, found
+   * by a content hash (see intern_pool). stats().bytes still counts each
+   * entry's value in full. cold (compressed) entries are not shared.
+   * until disable_interning() get throws; read with get_const or
+   * get_handle.
+   */
+  void enable_interning(size_t expected_values = 64) {
+    auto lock = acquire();
+    shared_values.store(true, std::memory_order_release);
+    if (!pool)
+      pool.reset(new intern_pool<V>(expected_values));
+  }
+
+  /**
+   * give every entry whose value is shared a copy of its own, so get can
+   * hand out writable pointers again. O(entries) copies, done once.
+   */
+  void disable_interning() {
+    auto lock = acquire();
+    if (!pool)
+      return;
+    pool.reset();
+    lmap *maps[PRIORITY_LEVELS + 1] = {&lhm, &pinned};
+    for (int l = 1; l < PRIORITY_LEVELS; ++l)
+      maps[l + 1] = levels[l].get();
+    for (lmap *m : maps) {
+      if (!m)
+        continue;
+      for (auto it = m->begin(); it != m->end(); ++it) {
+        if (it->second.use_count() > 1)
+          it->second = cell(*it->second);
+      }
+    }
+    // front cache 里还留着共享值的句柄
+    generation.fetch_add(1, std::memory_order_release);
+    shared_values.store(false, std::memory_order_release);
+  }
+
+  // distinct values in the interning pool, 0 when it is off
+  size_t interned() {
+    auto lock = acquire();
+    if (!pool)
+      return 0;
+    pool->purge();
+    return pool->size();
+  }
+
+  /**
+   * keep only the hot_entries most recently used entries as plain
+   * matrices; older ones are stored packed (see packed_matrix) and
+   * unpacked on get, so the same memory holds more entries.
+   * capacity still counts both. hot_entries must be at least 1.
+   */
+  void enable_compression(int hot_entries) {
+    static_assert(PACKABLE, "compression needs Matrix<int> values");
+    auto lock = acquire();
+    if (!cold) {
+      cold.reset(new cold_map());
+      cold->set_reclaimer(rec.get());
+    }
+    hot = hot_entries < 1 ? 1 : hot_entries;
+    demote_locked();
+  }
+
+  // unpack every cold entry again, keeping the recency order
+  void disable_compression() {
+    static_assert(PACKABLE, "compression needs Matrix<int> values");
+    auto lock = acquire();
+    if (!cold)
+      return;
+    lmap all;
+    all.reserve(cold->size() + lhm.size());
+    for (auto it = cold->begin(); it != cold->end(); ++it) {
+      counter.adjust(value_bytes(it->second), 0);
+      all.insert(
+          typename lmap::value_type(it->first, stored(it->second.unpack())));
+    }
     for (auto it = lhm.begin(); it != lhm.end(); ++it) {
-      std::cout << it->first.val << " " << it->second << std::endl;
+      counter.adjust(value_bytes(it->second), 0);
+      all.insert(*it);
+    }
+    cold->clear();
+    cold.reset();
+    lhm = all;
+    for (auto it = lhm.begin(); it != lhm.end(); ++it)
+      counter.adjust(0, value_bytes(it->second));
+  }
+
+  /**
+   * keep evicted values in a memory-mapped file at path; a get that
+   * misses in memory reads the value back and promotes it. the file
+   * starts at segment_bytes and is deleted when the tier is disabled.
+   * stats() still counts such a get as a (memory) miss.
+   * return false if the file cannot be created.
+   */
+  bool enable_spill(const char *path, uint64_t segment_bytes = 64 << 20) {
+    static_assert(PACKABLE, "the spill tier needs Matrix<int> values");
+    auto lock = acquire();
+    spill.reset(new spill_tier(path, segment_bytes));
+    if (!spill->ok()) {
+      spill.reset();
+      update_quick_miss_locked();
+      return false;
+    }
+    update_quick_miss_locked();
+    return true;
+  }
+  void disable_spill() {
+    auto lock = acquire();
+    if (spill)
+      spill->clear(rec.get());
+    spill.reset();
+    update_quick_miss_locked();
+  }
+
+  /**
+   * manual: evicted and cleared nodes, plain or compressed, and the
+   * spill tier's index dropped by clear() wait for reclaim().
+   * background: a dedicated thread frees them as they are retired.
+   * switching mode frees whatever is still pending.
+   */
+  void set_reclaim_mode(reclaim_mode mode) {
+    auto lock = acquire();
+    lmap *maps[PRIORITY_LEVELS + 1] = {&lhm, &pinned};
+    for (int l = 1; l < PRIORITY_LEVELS; ++l)
+      maps[l + 1] = levels[l].get();
+    for (lmap *m : maps) {
+      if (m)
+        m->set_reclaimer(nullptr);
+    }
+    if (cold)
+      cold->set_reclaimer(nullptr);
+    if (mode == reclaim_mode::inline_free)
+      rec.reset();
+    else
+      rec = std::make_shared<reclaimer>(mode == reclaim_mode::background);
+    for (lmap *m : maps) {
+      if (m)
+        m->set_reclaimer(rec.get());
+    }
+    if (cold)
+      cold->set_reclaimer(rec.get());
+  }
+
+  /**
+   * free the nodes retired in manual mode on the calling thread,
+   * without holding the cache lock. a reclaimer replaced by
+   * set_reclaim_mode meanwhile lives until this call is done with it
+   */
+  void reclaim() {
+    std::shared_ptr<reclaimer> r;
+    {
+      auto lock = acquire();
+      r = rec;
+    }
+    if (r)
+      r->reclaim();
+  }
+
+  int capacity() {
+    auto lock = acquire();
+    return n;
+  }
+
+  /**
+   * change the capacity, evicting least recently used entries to fit in
+   * one pass (see evict_bulk_locked). pinned entries stay even if they
+   * alone exceed the new capacity
+   */
+  void resize(int new_capacity) {
+    auto lock = acquire();
+    n = new_capacity;
+    size_t have = entries();
+    if ((int)have > n)
+      evict_bulk_locked(have - std::max(n, 0));
+  }
+
+  /**
+   * remember the hashes of the last `entries` evicted keys (no values), so
+   * take_ghost_hits() can tell how many misses a larger cache would have
+   * saved. 0 turns it off.
+   */
+  void enable_ghosts(size_t entries) {
+    auto lock = acquire();
+    ghost_hits = 0;
+    if (entries == 0)
+      ghosts.reset();
+    else
+      ghosts.reset(new ghost_list(entries));
+    update_quick_miss_locked();
+  }
+
+  /**
+   * misses on recently evicted keys since the last call
+   */
+  size_t take_ghost_hits() {
+    auto lock = acquire();
+    size_t res = ghost_hits;
+    ghost_hits = 0;
+    return res;
+  }
+
+  /**
+   * write the entries from least to most recently used to path.
+   * layout (native endianness): SNAPSHOT_MAGIC, u64 count, then per entry
+   * i32 key, i32 class (0 .. PRIORITY_LEVELS - 1, or PINNED_CLASS),
+   * u64 rows, u64 cols and rows * cols i32 in row-major order.
+   * the file is written to path.tmp and renamed, so a crash never leaves
+   * a half written snapshot. return false on any I/O error.
+   */
+  bool dump(const char *path) {
+    static_assert(PACKABLE, "snapshots need Matrix<int> values");
+    auto lock = acquire();
+    std::string tmp = std::string(path) + ".tmp";
+    std::FILE *f = std::fopen(tmp.c_str(), "wb");
+    if (f == nullptr)
+      return false;
+    std::vector<char> buf(1 << 20);
+    std::setvbuf(f, buf.data(), _IOFBF, buf.size());
+
+    bool ok = std::fwrite(SNAPSHOT_MAGIC, 1, 8, f) == 8;
+    uint64_t count = entries();
+    ok = ok && std::fwrite(&count, sizeof(count), 1, f) == 1;
+    for_each_locked([&ok, f](const Integer &k, const Matrix<int> &mat,
+                             int level) {
+      int32_t head[2] = {k.val, level};
+      uint64_t dims[2] = {mat.RowSize(), mat.ColSize()};
+      ok = ok && std::fwrite(head, sizeof(head), 1, f) == 1 &&
+           std::fwrite(dims, sizeof(dims), 1, f) == 1;
+      if (ok && mat.size() > 0)
+        ok = std::fwrite(mat.data(), sizeof(int), mat.size(), f) ==
+             mat.size();
+    });
+    ok = (std::fclose(f) == 0) && ok;
+    if (ok)
+      ok = std::rename(tmp.c_str(), path) == 0;
+    if (!ok)
+      std::remove(tmp.c_str());
+    return ok;
+  }
+
+  /**
+   * replace the contents with a snapshot written by dump(), keeping its
+   * recency order and each entry's priority class or pin. if it holds
+   * more than n records only the last n are read, and a key recorded
+   * twice keeps its later value, class and position. pinned records past
+   * the pin limit are loaded unpinned, in class 0.
+   * the file is mapped, each matrix copied with one memcpy and appended
+   * in file order; the filter and counters are rebuilt once at the end.
+   * return false, leaving
+   * the cache untouched, if the file is missing or malformed, including
+   * an unknown class, a dimension no Matrix can have or elements the file
+   * is too short to hold.
+   */
+  bool load(const char *path) {
+    static_assert(PACKABLE, "snapshots need Matrix<int> values");
+    mapped_file file;
+    if (!file.open(path))
+      return false;
+    const char *p = file.data(), *end = p + file.size();
+    uint64_t count;
+    if (file.size() < 16 || std::memcmp(p, SNAPSHOT_MAGIC, 8) != 0)
+      return false;
+    std::memcpy(&count, p + 8, sizeof(count));
+    p += 16;
+
+    // 先校验整个文件，失败时不改动缓存
+    std::vector<const char *> records;
+    records.reserve(std::min<uint64_t>(count, file.size() / RECORD_HEADER));
+    for (uint64_t i = 0; i < count; ++i) {
+      int32_t level;
+      uint64_t dims[2];
+      if (end - p < (ptrdiff_t)RECORD_HEADER)
+        return false;
+      std::memcpy(&level, p + sizeof(int32_t), sizeof(level));
+      std::memcpy(dims, p + 2 * sizeof(int32_t), sizeof(dims));
+      uint64_t left = (end - p) - RECORD_HEADER;
+      if (level != PINNED_CLASS && (level < 0 || level >= PRIORITY_LEVELS))
+        return false;
+      // 0 x N 是合法的空矩阵，但任一维都不能超过 Matrix 能容纳的大小
+      if (std::max(dims[0], dims[1]) > Matrix<int>::MaxSize())
+        return false;
+      if (dims[1] != 0 && dims[0] > left / sizeof(int) / dims[1])
+        return false;
+      uint64_t body = dims[0] * dims[1] * sizeof(int);
+      records.push_back(p);
+      p += RECORD_HEADER + body;
+    }
+    if (p != end)
+      return false;
+
+    // 重复的 key 只留最后一条记录，顺序也按最后一条算
+    std::vector<std::pair<int32_t, size_t>> last(records.size());
+    for (size_t r = 0; r < records.size(); ++r) {
+      std::memcpy(&last[r].first, records[r], sizeof(int32_t));
+      last[r].second = r;
+    }
+    std::sort(last.begin(), last.end());
+    std::vector<size_t> keep;
+    keep.reserve(last.size());
+    for (size_t i = 0; i < last.size(); ++i) {
+      if (i + 1 == last.size() || last[i + 1].first != last[i].first)
+        keep.push_back(last[i].second);
+    }
+    std::sort(keep.begin(), keep.end());
+
+    auto lock = acquire();
+    clear_locked();
+    if (spill)
+      spill->clear(rec.get());
+    size_t limit = std::max(n, 0);
+    size_t skip = keep.size() > limit ? keep.size() - limit : 0;
+    lhm.reserve(keep.size() - skip);
+    size_t bytes = 0;
+    for (size_t r = skip; r < keep.size(); ++r) {
+      const char *q = records[keep[r]];
+      int32_t head[2];
+      uint64_t dims[2];
+      std::memcpy(head, q, sizeof(head));
+      std::memcpy(dims, q + sizeof(head), sizeof(dims));
+      q += RECORD_HEADER;
+      Matrix<int> mat(dims[0], dims[1]);
+      if (mat.size() > 0)
+        std::memcpy(mat.data(), q, mat.size() * sizeof(int));
+      lmap *to = &level_map(head[1]);
+      if (head[1] == PINNED_CLASS && (int)pinned.size() < pin_limit &&
+          (int)pinned.size() + 1 < n)
+        to = &pinned;
+      to->insert(typename lmap::value_type(Integer(head[0]), stored(mat)));
+      uint64_t h = Hash()(Integer(head[0]));
+      bytes += value_bytes(mat);
+      if (ghosts)
+        ghosts->take(h);
+      if (filter)
+        filter->add(h);
+    }
+    counter.insert(bytes, keep.size() - skip);
+    demote_locked();
+    return true;
+  }
+
+  /**
+   * every entry as "key " followed by operator<< of its value and a
+   * newline. for lru the text is built with FormatMatrix and written in
+   * large chunks instead of element by element
+   */
+  void print() {
+    auto lock = acquire();
+    if constexpr (PACKABLE) {
+      if (PlainTextStream(std::cout)) {
+        print_formatted_locked();
+        return;
+      }
+    }
+    for_each_locked([](const Integer &key, const V &val, int) {
+      std::cout << key.val << " " << val << std::endl;
+    });
+  }
+
+private:
+  void print_formatted_locked() {
+    std::string text;
+    text.reserve(1 << 16);
+    for_each_locked([&](const Integer &key, const Matrix<int> &mat, int) {
+      char num[16];
+      text.append(num, std::to_chars(num, num + sizeof(num), key.val).ptr);
+      text += ' ';
+      FormatMatrix(text, mat);
+      text += '\n';
+      if (text.size() >= (1 << 16)) {
+        std::cout.write(text.data(), text.size());
+        text.clear();
+      }
+    });
+    std::cout.write(text.data(), text.size());
+    std::cout.flush();
+  }
+};
+
+// the cache of Integer -> Matrix<int> the rest of the library works with
+using lru = basic_lru<Matrix<int>>;
+
+/**
+ * shares a fixed total capacity among several lru instances.
+ * every attached cache keeps a ghost list of ghost_entries hashes; each
+ * rebalance() reads how many misses each ghost list caught since the
+ * previous call, i.e. the marginal benefit of growing that cache, and
+ * moves step entries of capacity from the cache with the lowest benefit
+ * to the one with the highest. call it periodically, e.g. every few
+ * thousand requests.
+ */
+class capacity_coordinator {
+  std::vector<lru *> caches;
+  int step;
+  int min_capacity;
+  size_t ghost_entries;
+
+public:
+  capacity_coordinator(int step = 16, int min_capacity = 1,
+                       size_t ghost_entries = 256)
+      : step(step), min_capacity(min_capacity), ghost_entries(ghost_entries) {
+  }
+
+  // the cache must outlive the coordinator
+  void attach(lru &cache) {
+    cache.enable_ghosts(ghost_entries);
+    caches.push_back(&cache);
+  }
+
+  /**
+   * return whether capacity was moved
+   */
+  bool rebalance() {
+    if (caches.size() < 2)
+      return false;
+    std::vector<size_t> benefit(caches.size());
+    for (size_t i = 0; i < caches.size(); ++i)
+      benefit[i] = caches[i]->take_ghost_hits();
+
+    int to = -1, from = -1;
+    for (size_t i = 0; i < caches.size(); ++i) {
+      if (to == -1 || benefit[i] > benefit[to])
+        to = i;
+    }
+    for (size_t i = 0; i < caches.size(); ++i) {
+      if ((int)i == to || caches[i]->capacity() - step < min_capacity)
+        continue;
+      if (from == -1 || benefit[i] < benefit[from])
+        from = i;
+    }
+    if (from == -1 || benefit[to] <= benefit[from])
+      return false;
+
+    // 先缩小再扩大，总容量在任何时刻都不超过预算
+    caches[from]->resize(caches[from]->capacity() - step);
+    caches[to]->resize(caches[to]->capacity() + step);
+    return true;
+  }
+};
+
+/**
+ * adjusts an lru's capacity to the memory pressure of the host (see
+ * read_memory_usage). while usage is above high of the limit each poll
+ * shrinks the capacity by a quarter, while it is below low each poll
+ * grows it by an eighth, always within [min_capacity, max_capacity].
+ * poll() can be called by hand, or start() runs it on its own thread.
+ */
+class memory_watcher {
+  lru &cache;
+  int min_capacity;
+  int max_capacity;
+  double high;
+  double low;
+  std::string cgroup_dir = "/sys/fs/cgroup";
+  std::string meminfo = "/proc/meminfo";
+
+  std::thread worker;
+  std::mutex mtx;
+  std::condition_variable cv;
+  bool stopping = false;
+
+public:
+  // the cache must outlive the watcher
+  memory_watcher(lru &cache, int min_capacity, int max_capacity,
+                 double high = 0.9, double low = 0.7)
+      : cache(cache), min_capacity(min_capacity), max_capacity(max_capacity),
+        high(high), low(low) {}
+  memory_watcher(const memory_watcher &) = delete;
+  memory_watcher &operator=(const memory_watcher &) = delete;
+  ~memory_watcher() { stop(); }
+
+  // read usage from elsewhere, e.g. a parent cgroup
+  void set_sources(const std::string &cgroup, const std::string &info) {
+    std::lock_guard<std::mutex> lock(mtx);
+    cgroup_dir = cgroup;
+    meminfo = info;
+  }
+
+  /**
+   * check the pressure once and resize. return whether the capacity
+   * changed
+   */
+  bool poll() {
+    uint64_t used, limit;
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      if (!read_memory_usage(used, limit, cgroup_dir, meminfo))
+        return false;
+    }
+    double usage = (double)used / limit;
+    int cap = cache.capacity();
+    int next = cap;
+    if (usage > high)
+      next = cap - std::max(1, cap / 4);
+    else if (usage < low)
+      next = cap + std::max(1, cap / 8);
+    next = std::max(min_capacity, std::min(max_capacity, next));
+    if (next == cap)
+      return false;
+    cache.resize(next);
+    return true;
+  }
+
+  void start(std::chrono::milliseconds interval) {
+    stop();
+    stopping = false;
+    worker = std::thread([this, interval] {
+      std::unique_lock<std::mutex> lock(mtx);
+      while (!cv.wait_for(lock, interval, [this] { return stopping; })) {
+        lock.unlock();
+        poll();
+        lock.lock();
+      }
+    });
+  }
+
+  void stop() {
+    if (!worker.joinable())
+      return;
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      stopping = true;
     }
+    cv.notify_one();
+    worker.join();
   }
 };
 }; // namespace sjtu
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -0,0 +1,127 @@
+#ifndef SJTU_MAPPED_FILE_HPP
+#define SJTU_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sjtu {
+
+/**
+ * read-only mapping of a whole file, unmapped on destruction
+ */
+class mapped_file {
+  void *addr = nullptr;
+  size_t len = 0;
+  bool opened = false;
+
+public:
+  mapped_file() = default;
+  explicit mapped_file(const char *path) { open(path); }
+  mapped_file(const mapped_file &) = delete;
+  mapped_file &operator=(const mapped_file &) = delete;
+  ~mapped_file() { close(); }
+
+  /**
+   * return false if the file cannot be opened or mapped
+   */
+  bool open(const char *path) {
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+      return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      ::close(fd);
+      return false;
+    }
+    len = st.st_size;
+    if (len > 0) {
+      addr = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr == MAP_FAILED) {
+        addr = nullptr;
+        len = 0;
+        ::close(fd);
+        return false;
+      }
+      // 顺序读取，让内核尽早预读
+      madvise(addr, len, MADV_SEQUENTIAL);
+    }
+    ::close(fd); // 映射建立后 fd 可以关闭
+    opened = true;
+    return true;
+  }
+
+  void close() {
+    if (addr != nullptr)
+      munmap(addr, len);
+    addr = nullptr;
+    len = 0;
+    opened = false;
+  }
+
+  bool is_open() const { return opened; }
+  const char *data() const { return static_cast<const char *>(addr); }
+  size_t size() const { return len; }
+};
+
+/**
+ * read-write shared mapping of a file created with a fixed size,
+ * unmapped on destruction
+ */
+class mapped_segment {
+  void *addr = nullptr;
+  size_t len = 0;
+
+public:
+  mapped_segment() = default;
+  mapped_segment(const mapped_segment &) = delete;
+  mapped_segment &operator=(const mapped_segment &) = delete;
+  ~mapped_segment() { close(); }
+
+  /**
+   * create (or truncate) path with bytes zeroed bytes and map it.
+   * return false on failure
+   */
+  bool create(const char *path, size_t bytes) {
+    close();
+    int fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+      return false;
+    if (ftruncate(fd, bytes) != 0) {
+      ::close(fd);
+      return false;
+    }
+    void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+      return false;
+    addr = p;
+    len = bytes;
+    return true;
+  }
+
+  void close() {
+    if (addr != nullptr)
+      munmap(addr, len);
+    addr = nullptr;
+    len = 0;
+  }
+
+  void swap(mapped_segment &other) {
+    std::swap(addr, other.addr);
+    std::swap(len, other.len);
+  }
+
+  bool is_open() const { return addr != nullptr; }
+  char *data() const { return static_cast<char *>(addr); }
+  size_t size() const { return len; }
+};
+
+} // namespace sjtu
+
+#endif
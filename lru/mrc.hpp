@@ -0,0 +1,213 @@
+#ifndef SJTU_MRC_HPP
+#define SJTU_MRC_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+#include "utility.hpp"
+
+namespace sjtu {
+
+/**
+ * online miss ratio curve estimation (SHARDS).
+ *
+ * a reference is sampled iff mix_hash(key) < threshold, so a key is either
+ * always or never sampled. reuse distances are measured among sampled keys
+ * and scaled by 1 / rate. at most max_samples keys are tracked: when the
+ * set overflows, the key with the largest hash is dropped and the
+ * threshold lowered to it, so memory stays constant however many keys
+ * the cache sees.
+ */
+class mrc_analyser {
+  static constexpr uint64_t EMPTY = ~0ULL;
+  static constexpr uint64_t RANGE = 1ULL << 24;
+
+  struct slot {
+    uint64_t key = EMPTY;
+    int stamp = 0;
+  };
+
+  // sampled keys -> last access stamp, linear probing
+  std::vector<slot> table;
+  // fenwick tree over stamps that are still some key's last access
+  std::vector<int> tree;
+  // max-heap of the sampled hashes, top is dropped when the set overflows
+  std::priority_queue<uint64_t> by_hash;
+  // weighted reuse distance histogram, the last bucket is "never reused"
+  std::vector<double> hist;
+
+  size_t max_samples;
+  size_t bucket_width;
+  uint64_t threshold;
+  size_t live = 0;
+  int now = 0;
+  double total = 0;
+
+  size_t home(uint64_t key) const { return key % table.size(); }
+
+  slot *lookup(uint64_t key) {
+    for (size_t i = home(key);; i = (i + 1) % table.size()) {
+      if (table[i].key == key)
+        return &table[i];
+      if (table[i].key == EMPTY)
+        return nullptr;
+    }
+  }
+
+  void put(uint64_t key, int stamp) {
+    size_t i = home(key);
+    while (table[i].key != EMPTY)
+      i = (i + 1) % table.size();
+    table[i].key = key;
+    table[i].stamp = stamp;
+  }
+
+  // backward shift deletion, keeps probe chains intact without tombstones
+  void erase(slot *s) {
+    size_t i = s - table.data();
+    size_t j = i;
+    table[i].key = EMPTY;
+    for (;;) {
+      j = (j + 1) % table.size();
+      if (table[j].key == EMPTY)
+        return;
+      size_t h = home(table[j].key);
+      bool movable = (i <= j) ? (h <= i || h > j) : (h <= i && h > j);
+      if (movable) {
+        table[i] = table[j];
+        table[j].key = EMPTY;
+        i = j;
+      }
+    }
+  }
+
+  void tree_add(int pos, int d) {
+    for (int i = pos + 1; i <= (int)tree.size(); i += i & -i)
+      tree[i - 1] += d;
+  }
+  int tree_prefix(int pos) const { // stamps in [0, pos]
+    int s = 0;
+    for (int i = pos + 1; i > 0; i -= i & -i)
+      s += tree[i - 1];
+    return s;
+  }
+
+  // stamps ran out: renumber the live keys 0..live-1 keeping their order
+  void compact() {
+    std::vector<slot *> order;
+    order.reserve(live);
+    for (slot &s : table)
+      if (s.key != EMPTY)
+        order.push_back(&s);
+    std::sort(order.begin(), order.end(),
+              [](const slot *a, const slot *b) { return a->stamp < b->stamp; });
+    std::fill(tree.begin(), tree.end(), 0);
+    for (size_t i = 0; i < order.size(); ++i) {
+      order[i]->stamp = i;
+      tree_add(i, 1);
+    }
+    now = order.size();
+  }
+
+  void shrink() {
+    while (live > max_samples) {
+      uint64_t key = by_hash.top();
+      by_hash.pop();
+      threshold = key;
+      slot *s = lookup(key);
+      tree_add(s->stamp, -1);
+      erase(s);
+      --live;
+    }
+  }
+
+  void record(double distance, double weight) {
+    size_t b = std::min<size_t>(distance / bucket_width, hist.size() - 1);
+    hist[b] += weight;
+    total += weight;
+  }
+
+public:
+  /**
+   * rate: initial fraction of keys sampled
+   * max_samples: bound on tracked keys
+   * max_capacity: largest cache size the curve covers
+   * buckets: histogram resolution over [0, max_capacity)
+   */
+  mrc_analyser(double rate = 0.01, size_t max_samples = 8192,
+               size_t max_capacity = 1 << 16, size_t buckets = 256)
+      : table(max_samples * 2 + 2), tree(max_samples * 4 + 4),
+        hist(buckets + 1, 0.0), max_samples(max_samples),
+        bucket_width(std::max<size_t>(1, max_capacity / buckets)),
+        threshold(rate >= 1 ? RANGE : (uint64_t)(rate * RANGE)) {}
+
+  // current sampling rate, lowered as the sample set overflows
+  double rate() const { return (double)threshold / RANGE; }
+
+  /**
+   * feed one reference to the analyser, key_hash is the cache's Hash
+   */
+  void access(uint64_t key_hash) {
+    uint64_t key = mix_hash(key_hash) % RANGE;
+    if (key >= threshold)
+      return;
+    double scale = 1.0 / rate();
+    if (now == (int)tree.size())
+      compact();
+
+    slot *s = lookup(key);
+    if (s != nullptr) {
+      int newer = live - tree_prefix(s->stamp);
+      record(newer * scale, scale);
+      tree_add(s->stamp, -1);
+      s->stamp = now;
+    } else {
+      hist.back() += scale;
+      total += scale;
+      put(key, now);
+      by_hash.push(key);
+      ++live;
+    }
+    tree_add(now++, 1);
+    shrink();
+  }
+
+  /**
+   * estimated hit ratio of an lru holding capacity entries
+   */
+  double hit_ratio(size_t capacity) const {
+    if (total == 0)
+      return 0;
+    double hits = 0;
+    size_t full = std::min(capacity / bucket_width, hist.size() - 1);
+    for (size_t b = 0; b < full; ++b)
+      hits += hist[b];
+    return hits / total;
+  }
+
+  /**
+   * (capacity, estimated hit ratio) at every bucket boundary
+   */
+  std::vector<pair<size_t, double>> curve() const {
+    std::vector<pair<size_t, double>> res;
+    double hits = 0;
+    for (size_t b = 0; b + 1 < hist.size(); ++b) {
+      hits += hist[b];
+      res.push_back(pair<size_t, double>((b + 1) * bucket_width,
+                                         total == 0 ? 0 : hits / total));
+    }
+    return res;
+  }
+
+  void reset() {
+    std::fill(hist.begin(), hist.end(), 0.0);
+    total = 0;
+  }
+};
+
+} // namespace sjtu
+
+#endif
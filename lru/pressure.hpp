@@ -0,0 +1,64 @@
+#ifndef SJTU_PRESSURE_HPP
+#define SJTU_PRESSURE_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace sjtu {
+
+// first unsigned number in the file, false if there is none
+inline bool read_number_file(const std::string &path, uint64_t &out) {
+  std::FILE *f = std::fopen(path.c_str(), "r");
+  if (f == nullptr)
+    return false;
+  unsigned long long v;
+  bool ok = std::fscanf(f, "%llu", &v) == 1;
+  std::fclose(f);
+  if (ok)
+    out = v;
+  return ok;
+}
+
+/**
+ * memory in use and the limit it counts against, in bytes.
+ * the cgroup v2 files memory.current / memory.max under cgroup_dir are
+ * used when the group has a limit; otherwise (memory.max is "max", or
+ * no cgroup v2) MemTotal - MemAvailable of MemTotal from meminfo.
+ * return false if neither can be read
+ */
+inline bool read_memory_usage(uint64_t &used, uint64_t &limit,
+                              const std::string &cgroup_dir = "/sys/fs/cgroup",
+                              const std::string &meminfo = "/proc/meminfo") {
+  if (read_number_file(cgroup_dir + "/memory.max", limit) &&
+      read_number_file(cgroup_dir + "/memory.current", used))
+    return limit > 0;
+
+  std::FILE *f = std::fopen(meminfo.c_str(), "r");
+  if (f == nullptr)
+    return false;
+  uint64_t total = 0, avail = 0;
+  bool has_total = false, has_avail = false;
+  char line[256];
+  while (std::fgets(line, sizeof(line), f)) {
+    unsigned long long kb;
+    if (std::sscanf(line, "MemTotal: %llu", &kb) == 1) {
+      total = kb * 1024;
+      has_total = true;
+    } else if (std::sscanf(line, "MemAvailable: %llu", &kb) == 1) {
+      avail = kb * 1024;
+      has_avail = true;
+    }
+  }
+  std::fclose(f);
+  if (!has_total || !has_avail || total == 0)
+    return false;
+  limit = total;
+  used = total > avail ? total - avail : 0;
+  return true;
+}
+
+} // namespace sjtu
+
+#endif
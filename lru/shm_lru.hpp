@@ -0,0 +1,358 @@
+#ifndef SJTU_SHM_LRU_HPP
+#define SJTU_SHM_LRU_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "class-integer.hpp"
+#include "class-matrix.hpp"
+#include "utility.hpp"
+
+namespace sjtu {
+
+/**
+ * an lru of Integer -> Matrix<int> kept entirely in a POSIX shared memory
+ * object, so every process on the host opening the same name shares one
+ * cache.
+ *
+ * the region holds a header, the bucket heads, a fixed table of capacity
+ * entries and one value slot of max_value_bytes per entry. links are
+ * entry indices instead of pointers since each process maps the region
+ * at its own address. all operations take a robust process-shared mutex
+ * in the header; if its owner dies holding it, the next process to lock
+ * it empties the cache (the links may be half updated) and carries on.
+ *
+ * the layout is computed from capacity and max_value_bytes, so every
+ * process opening a name must pass the same two values; open() fails on a
+ * mismatch. the region is created and initialised under an flock on the
+ * object, which the kernel drops if the creator dies half way; the next
+ * process to open it then initialises it again.
+ *
+ * values are copied in and out: get fills a Matrix owned by the caller.
+ */
+class shared_lru {
+  static constexpr uint64_t MAGIC = 0x53484d4c52550001ULL;
+  static constexpr uint32_t NIL = 0xffffffffu;
+
+  struct header {
+    std::atomic<uint64_t> magic; // 初始化完成后最后写入
+    uint32_t capacity;
+    uint32_t buckets;
+    uint64_t slot_bytes;
+    pthread_mutex_t lock;
+    uint32_t size;
+    uint32_t used; // entries [0, used) have been handed out
+    uint32_t head; // least recently used
+    uint32_t tail;
+  };
+
+  struct entry {
+    int32_t key;
+    uint32_t hnext; // bucket chain
+    uint32_t prev;  // recency list
+    uint32_t next;
+    uint64_t rows;
+    uint64_t cols;
+  };
+
+  void *addr = nullptr;
+  size_t len = 0;
+  header *hdr = nullptr;
+  uint32_t *bucket = nullptr;
+  entry *table = nullptr;
+  char *arena = nullptr;
+
+  static size_t align(size_t x) { return (x + 63) & ~size_t(63); }
+
+  static size_t region_size(uint32_t capacity, uint32_t buckets,
+                            uint64_t slot_bytes) {
+    return align(sizeof(header)) + align(buckets * sizeof(uint32_t)) +
+           align(capacity * sizeof(entry)) + capacity * slot_bytes;
+  }
+
+  void carve(uint32_t capacity, uint32_t buckets) {
+    char *p = static_cast<char *>(addr);
+    hdr = reinterpret_cast<header *>(p);
+    p += align(sizeof(header));
+    bucket = reinterpret_cast<uint32_t *>(p);
+    p += align(buckets * sizeof(uint32_t));
+    table = reinterpret_cast<entry *>(p);
+    p += align(capacity * sizeof(entry));
+    arena = p;
+  }
+
+  char *slot(uint32_t e) const { return arena + e * hdr->slot_bytes; }
+  uint32_t home(int32_t key) const {
+    return mix_hash((uint64_t)(uint32_t)key) % hdr->buckets;
+  }
+
+  // caller holds the lock
+  void reset_locked() {
+    hdr->size = hdr->used = 0;
+    hdr->head = hdr->tail = NIL;
+    for (uint32_t i = 0; i < hdr->buckets; ++i)
+      bucket[i] = NIL;
+  }
+
+  bool lock() {
+    int r = pthread_mutex_lock(&hdr->lock);
+    if (r == EOWNERDEAD) {
+      // 上一个持有者死在临界区里，链接可能不一致
+      reset_locked();
+      pthread_mutex_consistent(&hdr->lock);
+      return true;
+    }
+    return r == 0;
+  }
+  void unlock() { pthread_mutex_unlock(&hdr->lock); }
+
+  uint32_t find_locked(int32_t key) const {
+    for (uint32_t e = bucket[home(key)]; e != NIL; e = table[e].hnext) {
+      if (table[e].key == key)
+        return e;
+    }
+    return NIL;
+  }
+
+  void unlink_list(uint32_t e) {
+    entry &x = table[e];
+    if (x.prev != NIL)
+      table[x.prev].next = x.next;
+    else
+      hdr->head = x.next;
+    if (x.next != NIL)
+      table[x.next].prev = x.prev;
+    else
+      hdr->tail = x.prev;
+  }
+  void link_tail(uint32_t e) {
+    table[e].prev = hdr->tail;
+    table[e].next = NIL;
+    if (hdr->tail != NIL)
+      table[hdr->tail].next = e;
+    else
+      hdr->head = e;
+    hdr->tail = e;
+  }
+  void unlink_bucket(uint32_t e) {
+    uint32_t *p = &bucket[home(table[e].key)];
+    while (*p != e)
+      p = &table[*p].hnext;
+    *p = table[e].hnext;
+  }
+
+  void init(uint32_t capacity, uint32_t buckets, uint64_t slot_bytes) {
+    hdr->capacity = capacity;
+    hdr->buckets = buckets;
+    hdr->slot_bytes = slot_bytes;
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&hdr->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    reset_locked();
+    hdr->magic.store(MAGIC, std::memory_order_release);
+  }
+
+public:
+  shared_lru() = default;
+  shared_lru(const shared_lru &) = delete;
+  shared_lru &operator=(const shared_lru &) = delete;
+  ~shared_lru() { close(); }
+
+  /**
+   * attach to the shared object name (e.g. "/sjtu-lru"), creating it if
+   * it does not exist. every process must pass the same capacity and
+   * max_value_bytes (rounded up to 8); a matrix holding more int data
+   * than that is not cached. return false on failure, on a size mismatch
+   * or if another process keeps the object locked for over a second
+   */
+  bool open(const char *name, uint32_t capacity, uint64_t max_value_bytes) {
+    close();
+    if (capacity == 0)
+      return false;
+    uint64_t slot_bytes = (max_value_bytes + 7) & ~uint64_t(7);
+    uint32_t buckets = capacity + capacity / 2 + 1;
+    size_t bytes = region_size(capacity, buckets, slot_bytes);
+
+    int fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+    if (fd < 0)
+      return false;
+    // 初始化期间持有 flock，进程退出时内核自动释放
+    for (int i = 0; flock(fd, LOCK_EX | LOCK_NB) != 0; ++i) {
+      if ((errno != EWOULDBLOCK && errno != EINTR) || i > 1000) {
+        ::close(fd);
+        return false;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0;
+    if (ok && st.st_size == 0)
+      ok = ftruncate(fd, bytes) == 0; // 新建的，或创建者在扩容前退出
+    else if (ok)
+      ok = (size_t)st.st_size == bytes;
+    void *p = ok ? mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                        fd, 0)
+                 : MAP_FAILED;
+    if (p != MAP_FAILED) {
+      addr = p;
+      len = bytes;
+      carve(capacity, buckets);
+      // magic 未写入：新建的，或创建者在初始化中途退出
+      if (hdr->magic.load(std::memory_order_acquire) != MAGIC)
+        init(capacity, buckets, slot_bytes);
+      else if (hdr->capacity != capacity || hdr->slot_bytes != slot_bytes)
+        close();
+    }
+    flock(fd, LOCK_UN);
+    ::close(fd);
+    return is_open();
+  }
+
+  void close() {
+    if (addr != nullptr)
+      munmap(addr, len);
+    addr = nullptr;
+    len = 0;
+    hdr = nullptr;
+  }
+
+  // remove the name; processes still attached keep their mapping
+  static bool unlink(const char *name) { return shm_unlink(name) == 0; }
+
+  bool is_open() const { return addr != nullptr; }
+
+  /**
+   * insert or replace key, evicting the least recently used entry when
+   * full. return false if val does not fit a slot
+   */
+  bool save(const Integer &key, const Matrix<int> &val) {
+    uint64_t rows = val.RowSize(), cols = val.ColSize();
+    if (cols != 0 && rows > hdr->slot_bytes / sizeof(int) / cols)
+      return false;
+    if (!lock())
+      return false;
+    uint32_t e = find_locked(key.val);
+    if (e != NIL) {
+      unlink_list(e);
+    } else {
+      if (hdr->used < hdr->capacity) {
+        e = hdr->used++;
+      } else {
+        e = hdr->head; // 满了，复用最久未使用的条目
+        unlink_list(e);
+        unlink_bucket(e);
+        --hdr->size;
+      }
+      table[e].key = key.val;
+      table[e].hnext = bucket[home(key.val)];
+      bucket[home(key.val)] = e;
+      ++hdr->size;
+    }
+    table[e].rows = rows;
+    table[e].cols = cols;
+    if (val.size() > 0)
+      std::memcpy(slot(e), val.data(), val.size() * sizeof(int));
+    link_tail(e);
+    unlock();
+    return true;
+  }
+
+  /**
+   * copy the value of key into out and mark it most recently used.
+   * return false if key is not cached. the matrix is allocated with the
+   * lock released, so a throwing allocation never leaves it held; if the
+   * value changes shape meanwhile the lookup is repeated
+   */
+  bool get(const Integer &key, Matrix<int> &out) {
+    Matrix<int> mat;
+    for (;;) {
+      if (!lock())
+        return false;
+      uint32_t e = find_locked(key.val);
+      if (e == NIL) {
+        unlock();
+        return false;
+      }
+      uint64_t rows = table[e].rows, cols = table[e].cols;
+      if (rows == mat.RowSize() && cols == mat.ColSize()) {
+        unlink_list(e);
+        link_tail(e);
+        if (mat.size() > 0)
+          std::memcpy(mat.data(), slot(e), mat.size() * sizeof(int));
+        unlock();
+        out = std::move(mat);
+        return true;
+      }
+      unlock();
+      mat = Matrix<int>(rows, cols);
+    }
+  }
+
+  bool remove(const Integer &key) {
+    if (!lock())
+      return false;
+    uint32_t e = find_locked(key.val);
+    bool found = e != NIL;
+    if (found) {
+      unlink_list(e);
+      unlink_bucket(e);
+      --hdr->size;
+      // 把最后发出的条目挪进空位，保持 [0, used) 紧凑
+      uint32_t last = --hdr->used;
+      if (e != last) {
+        unlink_bucket(last);
+        table[e] = table[last];
+        std::memcpy(slot(e), slot(last), hdr->slot_bytes);
+        entry &x = table[e];
+        if (x.prev != NIL)
+          table[x.prev].next = e;
+        else
+          hdr->head = e;
+        if (x.next != NIL)
+          table[x.next].prev = e;
+        else
+          hdr->tail = e;
+        x.hnext = bucket[home(x.key)];
+        bucket[home(x.key)] = e;
+      }
+    }
+    unlock();
+    return found;
+  }
+
+  void clear() {
+    if (!lock())
+      return;
+    reset_locked();
+    unlock();
+  }
+
+  size_t size() {
+    if (!lock())
+      return 0;
+    size_t res = hdr->size;
+    unlock();
+    return res;
+  }
+  size_t capacity() const { return hdr->capacity; }
+};
+
+} // namespace sjtu
+
+#endif
@@ -0,0 +1,352 @@
+#ifndef SJTU_SPARSE_MATRIX_HPP
+#define SJTU_SPARSE_MATRIX_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "class-matrix.hpp"
+
+/**
+ * a matrix in compressed sparse row form: the non-zeros of row i are
+ * values()[row_offsets()[i] .. row_offsets()[i + 1]), at the columns in
+ * col_indices(), sorted within each row. memory and the cost of products
+ * and sums grow with the number of non-zeros instead of rows * cols.
+ * an element equal to _Td() counts as zero and is never stored. column
+ * indices are kept as uint32_t, so a matrix has at most 2^32 - 1 columns.
+ * sjtu::basic_lru<SparseMatrix<int>> caches such matrices, weighed by
+ * footprint().
+ */
+template<typename _Td>
+class SparseMatrix {
+    size_t n_rows = 0;
+    size_t n_cols = 0;
+    std::vector<size_t> row_ptr;
+    std::vector<uint32_t> col_idx;
+    std::vector<_Td> vals;
+
+    static size_t checked_cols(size_t cols)
+    {
+        if (cols > UINT32_MAX) {
+            throw std::length_error("too many columns");
+        }
+        return cols;
+    }
+public:
+    using value_type = _Td;
+
+    SparseMatrix() : row_ptr(1, 0) {}
+    // an all-zero matrix
+    SparseMatrix(size_t _n_rows, size_t _n_cols)
+        : n_rows(_n_rows), n_cols(checked_cols(_n_cols)), row_ptr(_n_rows + 1, 0) {}
+    // the non-zeros of a Matrix, a view or an expression
+    template<typename E>
+    explicit SparseMatrix(const MatrixExpr<E> &expr)
+    {
+        const E &e = expr.self();
+        n_rows = e.RowSize();
+        n_cols = checked_cols(e.ColSize());
+        row_ptr.assign(n_rows + 1, 0);
+        size_t k = 0;
+        for (size_t i = 0; i < n_rows; ++i) {
+            for (size_t j = 0; j < n_cols; ++j, ++k) {
+                const _Td &v = e.elem(k);
+                if (!(v == _Td())) {
+                    col_idx.push_back(uint32_t(j));
+                    vals.push_back(v);
+                }
+            }
+            row_ptr[i + 1] = vals.size();
+        }
+        col_idx.shrink_to_fit();
+        vals.shrink_to_fit();
+    }
+
+    size_t RowSize() const { return n_rows; }
+    size_t ColSize() const { return n_cols; }
+    // number of stored non-zeros
+    size_t nnz() const { return vals.size(); }
+    const std::vector<size_t> & row_offsets() const { return row_ptr; }
+    const std::vector<uint32_t> & col_indices() const { return col_idx; }
+    const std::vector<_Td> & values() const { return vals; }
+
+    // bytes held by the matrix, for cache weighting
+    size_t footprint() const
+    {
+        return sizeof(*this) + row_ptr.capacity() * sizeof(size_t) + col_idx.capacity() * sizeof(uint32_t)
+            + vals.capacity() * sizeof(_Td);
+    }
+
+    // element (i, j), _Td() if it is not stored
+    _Td at(size_t i, size_t j) const
+    {
+        if (i >= n_rows || j >= n_cols) {
+            throw std::out_of_range("index out of range");
+        }
+        auto b = col_idx.begin() + row_ptr[i], e = col_idx.begin() + row_ptr[i + 1];
+        auto p = std::lower_bound(b, e, j);
+        return p != e && *p == j ? vals[p - col_idx.begin()] : _Td();
+    }
+
+    /**
+     * append a row whose non-zeros are given by (cols[t], values[t]) with
+     * increasing cols; the matrix grows by one row. zeros are dropped
+     */
+    void push_row(const size_t *cols, const _Td *values, size_t count)
+    {
+        for (size_t t = 0; t < count; ++t) {
+            if (cols[t] >= n_cols || (t > 0 && cols[t] <= cols[t - 1])) {
+                throw std::invalid_argument("columns out of order");
+            }
+            if (!(values[t] == _Td())) {
+                col_idx.push_back(uint32_t(cols[t]));
+                vals.push_back(values[t]);
+            }
+        }
+        ++n_rows;
+        row_ptr.push_back(vals.size());
+    }
+
+    Matrix<_Td> to_dense() const
+    {
+        Matrix<_Td> res(n_rows, n_cols, _Td());
+        for (size_t i = 0; i < n_rows; ++i) {
+            _Td *r = res.row_data(i);
+            for (size_t p = row_ptr[i]; p < row_ptr[i + 1]; ++p) {
+                r[col_idx[p]] = vals[p];
+            }
+        }
+        return res;
+    }
+
+    /**
+     * row by row merge of a and b, keeping op(x, y) where it is not zero;
+     * a missing element is _Td()
+     */
+    template<typename Op>
+    static SparseMatrix merge(const SparseMatrix &a, const SparseMatrix &b, Op op)
+    {
+        if (a.n_rows != b.n_rows || a.n_cols != b.n_cols) {
+            throw std::invalid_argument("different matrics\'s sizes");
+        }
+        SparseMatrix res(a.n_rows, a.n_cols);
+        res.col_idx.reserve(a.nnz() + b.nnz());
+        res.vals.reserve(a.nnz() + b.nnz());
+        for (size_t i = 0; i < a.n_rows; ++i) {
+            size_t p = a.row_ptr[i], pe = a.row_ptr[i + 1];
+            size_t q = b.row_ptr[i], qe = b.row_ptr[i + 1];
+            while (p < pe || q < qe) {
+                uint32_t j;
+                _Td v;
+                if (q == qe || (p < pe && a.col_idx[p] < b.col_idx[q])) {
+                    j = a.col_idx[p];
+                    v = op(a.vals[p++], _Td());
+                } else if (p == pe || b.col_idx[q] < a.col_idx[p]) {
+                    j = b.col_idx[q];
+                    v = op(_Td(), b.vals[q++]);
+                } else {
+                    j = a.col_idx[p];
+                    v = op(a.vals[p++], b.vals[q++]);
+                }
+                if (!(v == _Td())) {
+                    res.col_idx.push_back(j);
+                    res.vals.push_back(v);
+                }
+            }
+            res.row_ptr[i + 1] = res.vals.size();
+        }
+        res.col_idx.shrink_to_fit();
+        res.vals.shrink_to_fit();
+        return res;
+    }
+};
+
+template<typename _Td>
+SparseMatrix<_Td> operator+(const SparseMatrix<_Td> &a, const SparseMatrix<_Td> &b)
+{
+    return SparseMatrix<_Td>::merge(a, b, [](const _Td &x, const _Td &y) { return _Td(x + y); });
+}
+
+template<typename _Td>
+SparseMatrix<_Td> operator-(const SparseMatrix<_Td> &a, const SparseMatrix<_Td> &b)
+{
+    return SparseMatrix<_Td>::merge(a, b, [](const _Td &x, const _Td &y) { return _Td(x - y); });
+}
+
+/**
+ * sparse x dense: every non-zero a(i, k) adds a(i, k) * row k of b to
+ * row i of the result, so the cost is nnz(a) * b.ColSize()
+ */
+template<typename _Td>
+Matrix<_Td> operator*(const SparseMatrix<_Td> &a, const Matrix<_Td> &b)
+{
+    if (a.ColSize() != b.RowSize()) {
+        throw std::invalid_argument("different matrics\'s sizes");
+    }
+    const size_t n = b.ColSize();
+    const std::vector<size_t> &rp = a.row_offsets();
+    const std::vector<uint32_t> &ci = a.col_indices();
+    const std::vector<_Td> &av = a.values();
+    Matrix<_Td> c(a.RowSize(), n, _Td());
+    for (size_t i = 0; i < a.RowSize(); ++i) {
+        _Td *cr = c.row_data(i);
+        for (size_t p = rp[i]; p < rp[i + 1]; ++p) {
+            const _Td aik = av[p];
+            const _Td *br = b.row_data(ci[p]);
+            for (size_t j = 0; j < n; ++j) {
+                cr[j] += aik * br[j];
+            }
+        }
+    }
+    return c;
+}
+
+// dense x sparse, skipping the zeros of a
+template<typename _Td>
+Matrix<_Td> operator*(const Matrix<_Td> &a, const SparseMatrix<_Td> &b)
+{
+    if (a.ColSize() != b.RowSize()) {
+        throw std::invalid_argument("different matrics\'s sizes");
+    }
+    const std::vector<size_t> &rp = b.row_offsets();
+    const std::vector<uint32_t> &ci = b.col_indices();
+    const std::vector<_Td> &bv = b.values();
+    Matrix<_Td> c(a.RowSize(), b.ColSize(), _Td());
+    for (size_t i = 0; i < a.RowSize(); ++i) {
+        _Td *cr = c.row_data(i);
+        const _Td *ar = a.row_data(i);
+        for (size_t k = 0; k < a.ColSize(); ++k) {
+            if (ar[k] == _Td())
+                continue;
+            for (size_t p = rp[k]; p < rp[k + 1]; ++p) {
+                cr[ci[p]] += ar[k] * bv[p];
+            }
+        }
+    }
+    return c;
+}
+
+/**
+ * sparse x sparse, row by row (Gustavson): the products for row i are
+ * summed in a dense accumulator and the touched columns collected, so the
+ * cost follows the number of multiplications rather than the sizes
+ */
+template<typename _Td>
+SparseMatrix<_Td> operator*(const SparseMatrix<_Td> &a, const SparseMatrix<_Td> &b)
+{
+    if (a.ColSize() != b.RowSize()) {
+        throw std::invalid_argument("different matrics\'s sizes");
+    }
+    const size_t n = b.ColSize();
+    const std::vector<size_t> &arp = a.row_offsets(), &brp = b.row_offsets();
+    const std::vector<uint32_t> &aci = a.col_indices(), &bci = b.col_indices();
+    const std::vector<_Td> &av = a.values(), &bv = b.values();
+    std::vector<_Td> acc(n, _Td());
+    std::vector<size_t> mark(n, size_t(-1)), touched, cols;
+    std::vector<_Td> values;
+    SparseMatrix<_Td> res(0, n);
+    for (size_t i = 0; i < a.RowSize(); ++i) {
+        touched.clear();
+        for (size_t p = arp[i]; p < arp[i + 1]; ++p) {
+            const _Td aik = av[p];
+            const size_t k = aci[p];
+            for (size_t q = brp[k]; q < brp[k + 1]; ++q) {
+                const size_t j = bci[q];
+                if (mark[j] != i) {
+                    mark[j] = i;
+                    acc[j] = _Td();
+                    touched.push_back(j);
+                }
+                acc[j] += aik * bv[q];
+            }
+        }
+        std::sort(touched.begin(), touched.end());
+        cols.clear();
+        values.clear();
+        for (size_t j : touched) {
+            cols.push_back(j);
+            values.push_back(acc[j]);
+        }
+        res.push_row(cols.data(), values.data(), cols.size());
+    }
+    return res;
+}
+
+// like Matrix, a scalar must not be wider than _Td
+template<typename _Td, typename S, typename = std::enable_if_t<ExprScalar<S, _Td>::value>>
+SparseMatrix<_Td> operator*(const SparseMatrix<_Td> &a, const S &b)
+{
+    return SparseMatrix<_Td>::merge(a, SparseMatrix<_Td>(a.RowSize(), a.ColSize()),
+                                    [&b](const _Td &x, const _Td &) { return _Td(x * b); });
+}
+
+template<typename _Td, typename S, typename = std::enable_if_t<ExprScalar<S, _Td>::value>>
+SparseMatrix<_Td> operator*(const S &b, const SparseMatrix<_Td> &a)
+{
+    return a * b;
+}
+
+template<typename _Td>
+bool operator==(const SparseMatrix<_Td> &a, const SparseMatrix<_Td> &b)
+{
+    return a.RowSize() == b.RowSize() && a.ColSize() == b.ColSize() && a.row_offsets() == b.row_offsets()
+        && a.col_indices() == b.col_indices() && a.values() == b.values();
+}
+
+// hash of the shape and the stored non-zeros, so an lru of sparse values can intern them
+template<typename _Td>
+uint64_t Fingerprint(const SparseMatrix<_Td> &a)
+{
+    static_assert(std::is_trivially_copyable<_Td>::value, "Fingerprint hashes the element bytes");
+    uint64_t h = sjtu::mix_hash(a.RowSize() * 0x100000001b3ULL ^ a.ColSize());
+    h = sjtu::hash_bytes(a.row_offsets().data(), a.row_offsets().size() * sizeof(size_t), h);
+    h = sjtu::hash_bytes(a.col_indices().data(), a.nnz() * sizeof(uint32_t), h);
+    return sjtu::hash_bytes(a.values().data(), a.nnz() * sizeof(_Td), h);
+}
+
+template<typename _Td>
+SparseMatrix<_Td> Transpose(const SparseMatrix<_Td> &a)
+{
+    const std::vector<size_t> &rp = a.row_offsets();
+    const std::vector<uint32_t> &ci = a.col_indices();
+    const std::vector<_Td> &av = a.values();
+    // 先数出每列的非零元个数，再按行顺序填入，列下标自然有序
+    std::vector<size_t> start(a.ColSize() + 1, 0);
+    for (size_t j : ci) {
+        ++start[j + 1];
+    }
+    for (size_t j = 0; j < a.ColSize(); ++j) {
+        start[j + 1] += start[j];
+    }
+    std::vector<size_t> cols(a.nnz()), fill(start.begin(), start.end() - 1);
+    std::vector<_Td> values(a.nnz());
+    for (size_t i = 0; i < a.RowSize(); ++i) {
+        for (size_t p = rp[i]; p < rp[i + 1]; ++p) {
+            size_t q = fill[ci[p]]++;
+            cols[q] = i;
+            values[q] = av[p];
+        }
+    }
+    SparseMatrix<_Td> res(0, a.RowSize());
+    for (size_t j = 0; j < a.ColSize(); ++j) {
+        res.push_row(cols.data() + start[j], values.data() + start[j], start[j + 1] - start[j]);
+    }
+    return res;
+}
+
+/**
+ * the same text as operator<< of the dense matrix, zeros included, so
+ * sjtu::basic_lru<SparseMatrix<_Td>>::print() works. the text has an
+ * entry for every element anyway, so it goes through to_dense()
+ */
+template<typename _Td>
+std::ostream & operator<<(std::ostream &stream, const SparseMatrix<_Td> &a)
+{
+    return stream << a.to_dense();
+}
+
+#endif
@@ -0,0 +1,199 @@
+#ifndef SJTU_THREAD_POOL_HPP
+#define SJTU_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sjtu {
+
+/**
+ * a fixed set of worker threads running one parallel_for at a time.
+ *
+ * the indices of a parallel_for are split into one contiguous range per
+ * participant (the workers plus the calling thread). each participant
+ * takes indices from the front of its own range; when it runs dry it
+ * steals the back half of the fullest other range, so uneven tasks still
+ * keep every thread busy.
+ */
+class thread_pool {
+  struct range {
+    std::mutex mtx;
+    size_t begin = 0;
+    size_t end = 0;
+  };
+
+  struct job_base {
+    std::vector<range> ranges;
+    std::mutex err_mtx;
+    std::exception_ptr err;
+    explicit job_base(size_t participants) : ranges(participants) {}
+    virtual ~job_base() = default;
+    virtual void call(size_t i) = 0;
+
+    bool take(size_t self, size_t &i) {
+      range &own = ranges[self];
+      std::lock_guard<std::mutex> lock(own.mtx);
+      if (own.begin == own.end)
+        return false;
+      i = own.begin++;
+      return true;
+    }
+
+    // move the back half of the largest other range into ranges[self]
+    bool steal(size_t self) {
+      size_t victim = self, most = 0;
+      for (size_t v = 0; v < ranges.size(); ++v) {
+        if (v == self)
+          continue;
+        std::lock_guard<std::mutex> lock(ranges[v].mtx);
+        if (ranges[v].end - ranges[v].begin > most) {
+          most = ranges[v].end - ranges[v].begin;
+          victim = v;
+        }
+      }
+      if (victim == self)
+        return false;
+      size_t b, e;
+      {
+        std::lock_guard<std::mutex> lock(ranges[victim].mtx);
+        size_t left = ranges[victim].end - ranges[victim].begin;
+        if (left == 0)
+          return true; // 被别人抢先了，重新找
+        e = ranges[victim].end;
+        b = e - (left + 1) / 2;
+        ranges[victim].end = b;
+      }
+      std::lock_guard<std::mutex> lock(ranges[self].mtx);
+      ranges[self].begin = b;
+      ranges[self].end = e;
+      return true;
+    }
+
+    void run(size_t self) {
+      for (;;) {
+        size_t i;
+        while (take(self, i)) {
+          try {
+            call(i);
+          } catch (...) {
+            std::lock_guard<std::mutex> lock(err_mtx);
+            if (!err)
+              err = std::current_exception();
+          }
+        }
+        if (!steal(self))
+          return;
+      }
+    }
+  };
+
+  template <class F> struct job : job_base {
+    F &f;
+    job(size_t participants, F &f) : job_base(participants), f(f) {}
+    void call(size_t i) override { f(i); }
+  };
+
+  std::vector<std::thread> workers;
+  std::mutex submit; // held by the parallel_for the workers are running
+  std::mutex mtx;
+  std::condition_variable wake;
+  std::condition_variable idle;
+  job_base *current = nullptr;
+  size_t round = 0;
+  size_t busy = 0;
+  bool stopping = false;
+
+  static bool &inside_pool() {
+    static thread_local bool inside = false;
+    return inside;
+  }
+
+  void work(size_t self) {
+    inside_pool() = true;
+    size_t seen = 0;
+    std::unique_lock<std::mutex> lock(mtx);
+    for (;;) {
+      wake.wait(lock, [&] { return stopping || round != seen; });
+      if (stopping)
+        return;
+      seen = round;
+      job_base *j = current;
+      lock.unlock();
+      j->run(self);
+      lock.lock();
+      if (--busy == 0)
+        idle.notify_one();
+    }
+  }
+
+public:
+  /**
+   * threads counts the calling thread, so threads - 1 workers are started
+   */
+  explicit thread_pool(size_t threads) {
+    for (size_t i = 1; i < threads; ++i)
+      workers.emplace_back(&thread_pool::work, this, i);
+  }
+  thread_pool(const thread_pool &) = delete;
+  thread_pool &operator=(const thread_pool &) = delete;
+  ~thread_pool() {
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (auto &t : workers)
+      t.join();
+  }
+
+  size_t size() const { return workers.size() + 1; }
+
+  /**
+   * run f(i) for every i in [0, count) and wait for all of them. the
+   * first exception thrown by f is rethrown here once every index has
+   * run. called from inside one of this pool's tasks, or while another
+   * thread's parallel_for has the workers, it runs serially on the
+   * calling thread rather than queueing behind it.
+   */
+  template <class F> void parallel_for(size_t count, F f) {
+    if (count == 0)
+      return;
+    std::unique_lock<std::mutex> serial(submit, std::defer_lock);
+    if (workers.empty() || count == 1 || inside_pool() ||
+        !serial.try_lock()) {
+      for (size_t i = 0; i < count; ++i)
+        f(i);
+      return;
+    }
+    job<F> j(size(), f);
+    for (size_t p = 0; p < size(); ++p) {
+      j.ranges[p].begin = count * p / size();
+      j.ranges[p].end = count * (p + 1) / size();
+    }
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      current = &j;
+      busy = workers.size();
+      ++round;
+    }
+    wake.notify_all();
+    inside_pool() = true;
+    j.run(0);
+    inside_pool() = false;
+    std::unique_lock<std::mutex> lock(mtx);
+    idle.wait(lock, [this] { return busy == 0; });
+    current = nullptr;
+    lock.unlock();
+    if (j.err)
+      std::rethrow_exception(j.err);
+  }
+};
+
+} // namespace sjtu
+
+#endif
@@ -1,9 +1,57 @@
 #ifndef SJTU_UTILITY_HPP
 #define SJTU_UTILITY_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <utility>
 namespace sjtu {
 
+// splitmix64 finalizer, spreads identity hashes such as std::hash<int>
+inline uint64_t mix_hash(uint64_t x) {
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+/**
+ * hash of n bytes at p. four independent lanes each fold in every fourth
+ * 8-byte word, so the multiplies overlap instead of forming one chain
+ */
+inline uint64_t hash_bytes(const void *p, size_t n, uint64_t seed = 0) {
+	const uint64_t P1 = 0x9e3779b185ebca87ULL, P2 = 0xc2b2ae3d27d4eb4fULL;
+	const unsigned char *s = static_cast<const unsigned char *>(p);
+	uint64_t lane[4] = {seed + P1, seed ^ P2, seed - P1, ~seed};
+	auto round = [&](uint64_t h, uint64_t w) {
+		h += w * P2;
+		h = (h << 31) | (h >> 33);
+		return h * P1;
+	};
+	size_t i = 0;
+	for (; i + 32 <= n; i += 32) {
+		for (int l = 0; l < 4; ++l) {
+			uint64_t w;
+			std::memcpy(&w, s + i + 8 * l, 8);
+			lane[l] = round(lane[l], w);
+		}
+	}
+	uint64_t h = n;
+	for (int l = 0; l < 4; ++l)
+		h = mix_hash(h ^ lane[l]);
+	for (; i + 8 <= n; i += 8) {
+		uint64_t w;
+		std::memcpy(&w, s + i, 8);
+		h = mix_hash(h ^ w);
+	}
+	if (i < n) {
+		uint64_t w = 0;
+		std::memcpy(&w, s + i, n - i);
+		h = mix_hash(h ^ w);
+	}
+	return h;
+}
+
 template<class T1, class T2>
 class pair {
 public:
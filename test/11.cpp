@@ -0,0 +1,79 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: mrc of a cyclic scan",
+    "test2: mrc of uniform keys",
+    "test3: lru hit_ratio_curve",
+    "",
+    "",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void cyclic_tester(){
+    std::cout<<c[2];
+    // 500 keys in a loop: lru misses everything below 500 entries, hits everything above
+    sjtu::mrc_analyser a(1.0,1024,1000,20);
+    for(int r=0;r<20;r++){
+        for(int k=0;k<500;k++){
+            a.access(k);
+        }
+    }
+    assert(a.hit_ratio(400)<0.05);
+    assert(a.hit_ratio(600)>0.9);
+    std::cout<<c[0]<<std::endl;
+}
+
+void uniform_tester(){
+    std::cout<<c[3];
+    // uniform over K keys: an lru of C entries hits about C / K of the time
+    const int K=4000;
+    sjtu::mrc_analyser a(0.25,1024,8000,40);
+    std::mt19937 rng(7);
+    for(int i=0;i<400000;i++){
+        a.access(rng()%K);
+    }
+    for(size_t cap=1000;cap<=3000;cap+=1000){
+        assert(std::fabs(a.hit_ratio(cap)-(double)cap/K)<0.1);
+    }
+    assert(a.hit_ratio(6000)>0.9);
+    std::cout<<c[0]<<std::endl;
+}
+
+void lru_curve_tester(){
+    std::cout<<c[4];
+    sjtu::lru tester(10);
+    assert(tester.hit_ratio_curve().empty());
+    tester.enable_mrc(1.0,1024,400,8);
+    for(int r=0;r<10;r++){
+        for(int k=0;k<100;k++){
+            tester.get(Integer(k));
+        }
+    }
+    auto curve=tester.hit_ratio_curve();
+    assert(curve.size()==8);
+    for(size_t i=1;i<curve.size();i++){
+        assert(curve[i].first>curve[i-1].first);
+        assert(curve[i].second>=curve[i-1].second);
+    }
+    assert(curve.back().second>0.8);
+    tester.disable_mrc();
+    assert(tester.hit_ratio_curve().empty());
+    std::cout<<c[0]<<std::endl;
+}
+
+int main(){
+    cyclic_tester();
+    uniform_tester();
+    lru_curve_tester();
+    std::cout << c[7] << std::endl;
+}
@@ -0,0 +1,229 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: dump & load",
+    "test2: mapped_file",
+    "test3: malformed snapshots",
+    "test4: duplicate keys",
+    "test5: loading in file order",
+    "test6: loading over a spill tier",
+    "test7: priority classes and pins",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+using value_type = sjtu::pair<Integer,Matrix<int> >;
+
+// append one record in dump()'s layout
+void put_record(std::string &s,int32_t key,uint64_t rows,uint64_t cols,const std::vector<int> &v,int32_t level=0){
+    s.append((const char *)&key,sizeof(key));
+    s.append((const char *)&level,sizeof(level));
+    s.append((const char *)&rows,sizeof(rows));
+    s.append((const char *)&cols,sizeof(cols));
+    s.append((const char *)v.data(),v.size()*sizeof(int));
+}
+
+std::string header(uint64_t count){
+    std::string s("SJLRU\x00\x00\x02",8);
+    s.append((const char *)&count,sizeof(count));
+    return s;
+}
+
+void write_file(const char *path,const std::string &s){
+    std::FILE *f=std::fopen(path,"wb");
+    std::fwrite(s.data(),1,s.size(),f);
+    std::fclose(f);
+}
+
+void round_trip_tester(){
+    std::cout<<c[2];
+    sjtu::lru a(50);
+    for(int i=0;i<80;i++){
+        a.save(value_type(Integer(i),Matrix<int>(i%4+1,i%3+1,i)));
+    }
+    a.save(value_type(Integer(99),Matrix<int>()));
+    a.save(value_type(Integer(98),Matrix<int>(0,3)));
+    a.get(Integer(40));
+    assert(a.dump("12.snap"));
+    sjtu::lru b(50);
+    assert(b.load("12.snap"));
+    for(int i=32;i<80;i++){
+        const Matrix<int> *m=b.get(Integer(i));
+        assert(m!=nullptr&&m->RowSize()==size_t(i%4+1)&&m->ColSize()==size_t(i%3+1));
+        assert((*m)[m->RowSize()-1][m->ColSize()-1]==i);
+    }
+    assert(b.get(Integer(99))!=nullptr&&b.get(Integer(99))->size()==0);
+    // an empty matrix keeps its shape
+    const Matrix<int> *e=b.get(Integer(98));
+    assert(e!=nullptr&&e->RowSize()==0&&e->ColSize()==3);
+    // the recency order survives: 40 was read last before the dump
+    sjtu::lru small(3);
+    assert(small.load("12.snap"));
+    assert(small.get(Integer(40))!=nullptr);
+    assert(small.get(Integer(99))!=nullptr);
+    assert(small.get(Integer(98))!=nullptr);
+    assert(small.get(Integer(79))==nullptr);
+    assert(!b.load("12.missing"));
+    assert(b.get(Integer(50))!=nullptr);
+    std::remove("12.snap");
+    std::cout<<c[0]<<std::endl;
+}
+
+void mapped_file_tester(){
+    std::cout<<c[3];
+    write_file("12.map","mapped bytes");
+    sjtu::mapped_file f;
+    assert(f.open("12.map"));
+    assert(f.size()==12&&std::memcmp(f.data(),"mapped bytes",12)==0);
+    assert(!f.open("12.missing"));
+    std::remove("12.map");
+    std::cout<<c[0]<<std::endl;
+}
+
+void malformed_tester(){
+    std::cout<<c[4];
+    sjtu::lru tester(10);
+    tester.save(value_type(Integer(1),Matrix<int>(1,1,1)));
+    std::string s=header(1);
+    put_record(s,2,uint64_t(1)<<62,0,{});
+    write_file("12.bad",s);
+    assert(!tester.load("12.bad"));
+    s=header(1);
+    put_record(s,2,3,uint64_t(1)<<62,{1,2,3});
+    write_file("12.bad",s);
+    assert(!tester.load("12.bad"));
+    s=header(2);
+    put_record(s,2,1,1,{5});
+    write_file("12.bad",s);
+    assert(!tester.load("12.bad"));
+    s=header(1);
+    put_record(s,2,1,1,{5});
+    s+='x';
+    write_file("12.bad",s);
+    assert(!tester.load("12.bad"));
+    assert(tester.get(Integer(1))!=nullptr&&tester.get(Integer(2))==nullptr);
+    std::remove("12.bad");
+    std::cout<<c[0]<<std::endl;
+}
+
+void duplicate_tester(){
+    std::cout<<c[5];
+    std::string s=header(4);
+    put_record(s,1,1,1,{10});
+    put_record(s,2,2,1,{20,21});
+    put_record(s,1,1,2,{30,31});
+    put_record(s,3,1,1,{40});
+    write_file("12.dup",s);
+    sjtu::lru tester(10);
+    tester.enable_negative_filter();
+    assert(tester.load("12.dup"));
+    sjtu::cache_stats st=tester.stats();
+    assert(st.bytes==sjtu::value_bytes(Matrix<int>(1,2))+sjtu::value_bytes(Matrix<int>(2,1))+sjtu::value_bytes(Matrix<int>(1,1)));
+    assert((*tester.get(Integer(1)))[0][1]==31);
+    tester.save(value_type(Integer(1),Matrix<int>(1,1,0)));
+    tester.save(value_type(Integer(1),Matrix<int>(1,1,0)));
+    tester.resize(0);
+    assert(tester.get(Integer(1))==nullptr&&tester.get(Integer(2))==nullptr);
+    assert(tester.stats().bytes==0);
+    std::remove("12.dup");
+    std::cout<<c[0]<<std::endl;
+}
+
+void order_tester(){
+    std::cout<<c[6];
+    std::string s=header(5);
+    put_record(s,1,1,1,{1});
+    put_record(s,2,1,1,{2});
+    put_record(s,3,1,1,{3});
+    put_record(s,1,1,1,{11});
+    put_record(s,3,1,1,{33});
+    write_file("12.order",s);
+    // three distinct keys fit, in the order of their last records: 2, 1, 3
+    sjtu::lru tester(3);
+    tester.enable_negative_filter();
+    assert(tester.load("12.order"));
+    sjtu::cache_stats st=tester.stats();
+    assert(st.inserts==3&&st.updates==0&&st.bytes==3*sjtu::value_bytes(Matrix<int>(1,1)));
+    tester.save(value_type(Integer(5),Matrix<int>(1,1,5)));
+    assert(tester.get(Integer(2))==nullptr);
+    assert((*tester.get(Integer(1)))[0][0]==11&&(*tester.get(Integer(3)))[0][0]==33);
+    // the oldest loaded entries go to the cold tier
+    sjtu::lru packed(10);
+    packed.enable_compression(1);
+    assert(packed.load("12.order"));
+    assert(packed.stats().bytes<3*sjtu::value_bytes(Matrix<int>(1,1)));
+    assert((*packed.get(Integer(2)))[0][0]==2&&(*packed.get(Integer(1)))[0][0]==11);
+    std::remove("12.order");
+    std::cout<<c[0]<<std::endl;
+}
+
+void spill_tester(){
+    std::cout<<c[7];
+    sjtu::lru a(10);
+    a.save(value_type(Integer(1),Matrix<int>(1,1,1)));
+    assert(a.dump("12.snap"));
+    sjtu::lru tester(1);
+    assert(tester.enable_spill("12.spill",1<<16));
+    tester.save(value_type(Integer(2),Matrix<int>(1,1,2)));
+    tester.save(value_type(Integer(3),Matrix<int>(1,1,3)));
+    // 2 now lives in the spill tier, and the snapshot replaces it too
+    assert(tester.load("12.snap"));
+    assert(tester.get(Integer(2))==nullptr&&tester.get(Integer(3))==nullptr);
+    assert((*tester.get(Integer(1)))[0][0]==1);
+    tester.disable_spill();
+    std::remove("12.snap");
+    std::cout<<c[0]<<std::endl;
+}
+
+void class_tester(){
+    std::cout<<c[8];
+    sjtu::lru a(10);
+    for(int i=0;i<6;i++){
+        a.save(value_type(Integer(i),Matrix<int>(1,1,i)),i%3);
+    }
+    assert(a.pin(Integer(0)));
+    assert(a.dump("12.snap"));
+    sjtu::lru b(6);
+    assert(b.load("12.snap"));
+    // class 0 goes first, then class 1, and the pinned 0 never
+    b.resize(3);
+    assert(b.get(Integer(3))==nullptr&&b.get(Integer(1))==nullptr&&b.get(Integer(4))==nullptr);
+    assert(b.get(Integer(2))!=nullptr&&b.get(Integer(5))!=nullptr);
+    b.resize(1);
+    assert(b.get(Integer(2))==nullptr&&b.get(Integer(5))==nullptr);
+    assert((*b.get(Integer(0)))[0][0]==0&&b.unpin(Integer(0)));
+    // pins beyond the pin limit are loaded unpinned
+    sjtu::lru tight(10);
+    tight.set_pin_limit(0);
+    assert(tight.load("12.snap")&&!tight.unpin(Integer(0)));
+    // an unknown class is malformed
+    std::string s=header(1);
+    put_record(s,1,1,1,{1},sjtu::lru::PRIORITY_LEVELS);
+    write_file("12.bad",s);
+    assert(!tight.load("12.bad")&&tight.get(Integer(0))!=nullptr);
+    std::remove("12.bad");
+    std::remove("12.snap");
+    std::cout<<c[0]<<std::endl;
+}
+
+int main(){
+    round_trip_tester();
+    mapped_file_tester();
+    malformed_tester();
+    duplicate_tester();
+    order_tester();
+    spill_tester();
+    class_tester();
+    std::cout << c[9] << std::endl;
+}
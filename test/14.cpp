@@ -0,0 +1,133 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: read_buffer",
+    "test2: buffered recency",
+    "test3: buffered reads under threads",
+    "test4: buffered reads during saves",
+    "",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+using value_type = sjtu::pair<Integer,Matrix<int> >;
+
+void read_buffer_tester(){
+    std::cout<<c[2];
+    sjtu::read_buffer buf;
+    bool full=false;
+    for(int i=0;i<32;i++){
+        full=buf.record(i);
+    }
+    assert(full);
+    std::vector<int> seen;
+    buf.drain([&seen](int key){ seen.push_back(key); });
+    assert(seen.size()==32);
+    for(int i=0;i<32;i++){
+        assert(seen[i]==i);
+    }
+    seen.clear();
+    buf.drain([&seen](int key){ seen.push_back(key); });
+    assert(seen.empty());
+    std::cout<<c[0]<<std::endl;
+}
+
+void recency_tester(){
+    std::cout<<c[3];
+    sjtu::lru tester(100);
+    for(int i=0;i<100;i++){
+        tester.save(value_type(Integer(i),Matrix<int>(2,2,i)));
+    }
+    tester.set_buffered_reads(true);
+    // the hit on 0 is replayed before the save evicts, so 1 goes instead
+    assert(tester.get(Integer(0))!=nullptr);
+    tester.save(value_type(Integer(100),Matrix<int>(2,2,100)));
+    assert(tester.get(Integer(1))==nullptr);
+    assert(tester.get(Integer(0))!=nullptr);
+    tester.set_buffered_reads(false);
+    tester.save(value_type(Integer(101),Matrix<int>(2,2,101)));
+    assert(tester.get(Integer(2))==nullptr);
+    std::cout<<c[0]<<std::endl;
+}
+
+void threads_tester(){
+    std::cout<<c[4];
+    const int keys=1000,reads=20000,readers=4;
+    sjtu::lru tester(2*keys);
+    for(int i=0;i<keys;i++){
+        tester.save(value_type(Integer(i),Matrix<int>(2,2,i)));
+    }
+    tester.set_buffered_reads(true);
+    std::atomic<int> bad(0);
+    std::vector<std::thread> th;
+    for(int t=0;t<readers;t++){
+        th.emplace_back([&,t](){
+            for(int i=0;i<reads;i++){
+                int k=(i*7+t)%keys;
+                const Matrix<int> *m=tester.get(Integer(k));
+                if(m==nullptr||(*m)[1][1]!=k)
+                    bad++;
+            }
+        });
+    }
+    // new keys only, nothing the readers hold is evicted or replaced
+    th.emplace_back([&](){
+        for(int i=keys;i<keys+keys/2;i++){
+            tester.save(value_type(Integer(i),Matrix<int>(2,2,i)));
+        }
+    });
+    for(auto &x:th)x.join();
+    assert(bad==0);
+    assert(tester.stats().hits==size_t(readers*reads));
+    for(int i=0;i<keys+keys/2;i++){
+        assert(tester.get(Integer(i))!=nullptr);
+    }
+    std::cout<<c[0]<<std::endl;
+}
+
+void replace_tester(){
+    std::cout<<c[5];
+    const int keys=16,rounds=2000,readers=3;
+    sjtu::lru tester(keys/2);
+    tester.set_buffered_reads(true);
+    std::atomic<bool> done(false);
+    std::atomic<int> bad(0);
+    std::vector<std::thread> th;
+    for(int t=0;t<readers;t++){
+        th.emplace_back([&,t](){
+            for(int i=0;!done;i++){
+                const Matrix<int> *m=tester.get(Integer((i+t)%keys));
+                // still ours to read while other threads replace or evict it
+                if(m!=nullptr&&((*m)[0][0]%keys!=(i+t)%keys||(*m)[1][1]!=(*m)[0][0]))
+                    bad++;
+            }
+        });
+    }
+    for(int r=0;r<rounds;r++){
+        for(int k=0;k<keys;k++){
+            tester.save(value_type(Integer(k),Matrix<int>(8,8,r*keys+k)));
+        }
+    }
+    done=true;
+    for(auto &x:th)x.join();
+    assert(bad==0);
+    std::cout<<c[0]<<std::endl;
+}
+
+int main(){
+    read_buffer_tester();
+    recency_tester();
+    threads_tester();
+    replace_tester();
+    std::cout << c[7] << std::endl;
+}
@@ -0,0 +1,165 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: manual reclaim",
+    "test2: spill index",
+    "test3: compressed entries",
+    "test4: background reclaim",
+    "test5: reclaim while the mode changes",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+using value_type = sjtu::pair<Integer,Matrix<int> >;
+
+// every Integer alive is a key held by a list node or an index entry (each
+// entry has one of both), so Integer::counter tells whether retired nodes
+// have been freed yet
+void manual_tester(){
+    std::cout<<c[2];
+    int base=Integer::counter;
+    {
+        sjtu::lru tester(10);
+        tester.set_reclaim_mode(sjtu::reclaim_mode::manual);
+        for(int i=0;i<15;i++){
+            tester.save(value_type(Integer(i),Matrix<int>(4,4,i)));
+        }
+        assert(Integer::counter==base+2*10+5);
+        tester.reclaim();
+        assert(Integer::counter==base+2*10);
+        tester.clear();
+        assert(Integer::counter==base+10);
+        tester.reclaim();
+        assert(Integer::counter==base);
+        tester.save(value_type(Integer(1),Matrix<int>(1,1,1)));
+        assert(tester.get(Integer(1))!=nullptr);
+    }
+    assert(Integer::counter==base);
+    {
+        // an insert over an existing key retires the replaced node too
+        sjtu::reclaimer rec;
+        sjtu::linked_hashmap<Integer,Matrix<int>,Hash,Equal> map;
+        map.set_reclaimer(&rec);
+        map.insert(value_type(Integer(1),Matrix<int>(64,64,1)));
+        assert(Integer::counter==base+2);
+        map.insert(value_type(Integer(1),Matrix<int>(64,64,2)));
+        assert(Integer::counter==base+3);
+        rec.reclaim();
+        assert(Integer::counter==base+2);
+        assert(map.at(Integer(1))[63][63]==2);
+        map.set_reclaimer(nullptr);
+    }
+    assert(Integer::counter==base);
+    std::cout<<c[0]<<std::endl;
+}
+
+void spill_tester(){
+    std::cout<<c[3];
+    int base=Integer::counter;
+    {
+        sjtu::lru tester(5);
+        assert(tester.enable_spill("15.spill",1<<16));
+        tester.set_reclaim_mode(sjtu::reclaim_mode::manual);
+        for(int i=0;i<10;i++){
+            tester.save(value_type(Integer(i),Matrix<int>(2,2,i)));
+        }
+        tester.reclaim();
+        // 5 in memory, 5 keys in the spill index
+        assert(Integer::counter==base+2*5+5);
+        tester.clear();
+        assert(Integer::counter==base+5+5);
+        tester.reclaim();
+        assert(Integer::counter==base);
+        assert(tester.get(Integer(2))==nullptr);
+    }
+    assert(Integer::counter==base);
+    std::cout<<c[0]<<std::endl;
+}
+
+void compressed_tester(){
+    std::cout<<c[4];
+    int base=Integer::counter;
+    {
+        sjtu::lru tester(10);
+        tester.enable_compression(2);
+        tester.set_reclaim_mode(sjtu::reclaim_mode::manual);
+        for(int i=0;i<15;i++){
+            tester.save(value_type(Integer(i),Matrix<int>(4,4,i)));
+        }
+        // 8 of the 10 entries are cold, the evicted ones came from there;
+        // the hot nodes left behind by demotion are pending as well
+        assert(Integer::counter>=base+2*10+5);
+        tester.reclaim();
+        assert(Integer::counter==base+2*10);
+        // the cold nodes and the replaced hot ones are retired too
+        tester.disable_compression();
+        assert(Integer::counter>=base+2*10+8);
+        tester.reclaim();
+        assert(Integer::counter==base+2*10);
+        assert((*tester.get(Integer(7)))[3][3]==7);
+    }
+    assert(Integer::counter==base);
+    std::cout<<c[0]<<std::endl;
+}
+
+void background_tester(){
+    std::cout<<c[5];
+    int base=Integer::counter;
+    sjtu::lru tester(100);
+    tester.set_reclaim_mode(sjtu::reclaim_mode::background);
+    for(int i=0;i<100;i++){
+        tester.save(value_type(Integer(i),Matrix<int>(16,16,i)));
+    }
+    tester.clear();
+    for(int i=0;i<200&&Integer::counter!=base;i++){
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    assert(Integer::counter==base);
+    tester.set_reclaim_mode(sjtu::reclaim_mode::inline_free);
+    tester.save(value_type(Integer(1),Matrix<int>(1,1,1)));
+    assert(tester.get(Integer(1))!=nullptr);
+    std::cout<<c[0]<<std::endl;
+}
+
+void switch_tester(){
+    std::cout<<c[6];
+    int base=Integer::counter;
+    {
+        sjtu::lru tester(20);
+        std::atomic<bool> stop(false);
+        // a reclaimer replaced while reclaim() frees its batch must outlive it
+        std::thread freer([&](){
+            while(!stop) tester.reclaim();
+        });
+        for(int r=0;r<300;r++){
+            tester.set_reclaim_mode(r%2?sjtu::reclaim_mode::inline_free:sjtu::reclaim_mode::manual);
+            for(int i=0;i<40;i++){
+                tester.save(value_type(Integer(r*40+i),Matrix<int>(4,4,i)));
+            }
+        }
+        stop=true;
+        freer.join();
+        tester.reclaim();
+    }
+    assert(Integer::counter==base);
+    std::cout<<c[0]<<std::endl;
+}
+
+int main(){
+    manual_tester();
+    spill_tester();
+    compressed_tester();
+    background_tester();
+    switch_tester();
+    std::cout << c[7] << std::endl;
+}
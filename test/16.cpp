@@ -0,0 +1,147 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: spill_tier",
+    "test2: lru spill round trip",
+    "test3: disable_spill",
+    "test4: failed compaction",
+    "test5: spilling into an empty file",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+using value_type = sjtu::pair<Integer,Matrix<int> >;
+
+void spill_tier_tester(){
+    std::cout<<c[2];
+    sjtu::spill_tier tier("16.seg",4096);
+    assert(tier.ok());
+    for(int i=0;i<200;i++){
+        assert(tier.put(Integer(i),Matrix<int>(i%3+1,i%4+1,i)));
+    }
+    // the segment grew and every record is still readable
+    assert(tier.size()==200&&tier.file_bytes()>4096);
+    assert(tier.put(Integer(7),Matrix<int>(1,1,-7)));
+    Matrix<int> out;
+    assert(tier.take(Integer(7),out)&&out.RowSize()==1&&out.ColSize()==1&&out[0][0]==-7);
+    assert(!tier.take(Integer(7),out));
+    for(int i=100;i<200;i++){
+        tier.erase(Integer(i));
+    }
+    uint64_t live=tier.live_bytes();
+    assert(tier.compact());
+    assert(tier.live_bytes()==live);
+    for(int i=0;i<100;i++){
+        if(i==7)continue;
+        assert(tier.take(Integer(i),out));
+        assert(out.RowSize()==size_t(i%3+1)&&out.ColSize()==size_t(i%4+1)&&out[out.RowSize()-1][out.ColSize()-1]==i);
+    }
+    assert(tier.size()==0&&tier.live_bytes()==0);
+    std::cout<<c[0]<<std::endl;
+}
+
+void round_trip_tester(){
+    std::cout<<c[3];
+    sjtu::lru tester(10);
+    assert(tester.enable_spill("16.seg",4096));
+    for(int i=0;i<500;i++){
+        tester.save(value_type(Integer(i),Matrix<int>(i%7+1,i%5+1,i)));
+    }
+    for(int r=0;r<2;r++){
+        for(int i=0;i<500;i+=3){
+            const Matrix<int> *m=tester.get(Integer(i));
+            assert(m!=nullptr&&m->RowSize()==size_t(i%7+1)&&m->ColSize()==size_t(i%5+1));
+            assert((*m)[m->RowSize()-1][m->ColSize()-1]==i);
+        }
+    }
+    // values brought back from the spill tier are hits
+    sjtu::cache_stats st=tester.stats();
+    assert(st.hits==2*167&&st.misses==0);
+    // a new save wins over the spilled copy
+    tester.save(value_type(Integer(4),Matrix<int>(1,1,-4)));
+    for(int i=100;i<120;i++){
+        tester.get(Integer(i));
+    }
+    assert((*tester.get(Integer(4)))[0][0]==-4);
+    tester.clear();
+    assert(tester.get(Integer(499))==nullptr);
+    std::cout<<c[0]<<std::endl;
+}
+
+void disable_tester(){
+    std::cout<<c[4];
+    sjtu::lru tester(2);
+    assert(tester.enable_spill("16.seg",4096));
+    for(int i=0;i<5;i++){
+        tester.save(value_type(Integer(i),Matrix<int>(1,1,i)));
+    }
+    tester.disable_spill();
+    assert(tester.get(Integer(0))==nullptr);
+    std::FILE *f=std::fopen("16.seg","rb");
+    assert(f==nullptr);
+    assert(!tester.enable_spill("16.missing/seg",4096));
+    std::cout<<c[0]<<std::endl;
+}
+
+void failed_compact_tester(){
+    std::cout<<c[5];
+    sjtu::spill_tier tier("16.fail",4096);
+    for(int i=0;i<20;i++){
+        assert(tier.put(Integer(i),Matrix<int>(2,2,i)));
+    }
+    for(int i=0;i<10;i++){
+        tier.erase(Integer(i));
+    }
+    // a directory in place of the file makes the final rename fail
+    std::remove("16.fail");
+    assert(mkdir("16.fail",0700)==0);
+    std::FILE *f=std::fopen("16.fail/x","w");
+    std::fclose(f);
+    assert(!tier.compact());
+    Matrix<int> out;
+    for(int i=10;i<20;i++){
+        assert(tier.take(Integer(i),out)&&out==Matrix<int>(2,2,i));
+    }
+    std::remove("16.fail/x");
+    rmdir("16.fail");
+    std::cout<<c[0]<<std::endl;
+}
+
+void empty_file_tester(){
+    std::cout<<c[6];
+    {
+        sjtu::spill_tier tier("16.empty",0);
+        assert(tier.ok()&&tier.file_bytes()>0);
+        for(int i=0;i<100;i++){
+            assert(tier.put(Integer(i),Matrix<int>(8,8,i)));
+        }
+        Matrix<int> out;
+        assert(tier.take(Integer(42),out)&&out==Matrix<int>(8,8,42));
+    }
+    sjtu::lru tester(2);
+    assert(tester.enable_spill("16.empty",0));
+    for(int i=0;i<50;i++){
+        tester.save(value_type(Integer(i),Matrix<int>(4,4,i)));
+    }
+    assert((*tester.get(Integer(3)))[3][3]==3);
+    std::cout<<c[0]<<std::endl;
+}
+
+int main(){
+    spill_tier_tester();
+    round_trip_tester();
+    disable_tester();
+    failed_compact_tester();
+    empty_file_tester();
+    std::cout << c[7] << std::endl;
+}
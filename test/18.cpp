@@ -0,0 +1,116 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: priority eviction order",
+    "test2: pinning",
+    "test3: pin limit",
+    "",
+    "",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+using value_type = sjtu::pair<Integer,Matrix<int> >;
+
+bool cached(sjtu::lru &tester,int k){
+    return tester.get(Integer(k))!=nullptr;
+}
+
+void priority_tester(){
+    std::cout<<c[2];
+    sjtu::lru tester(3);
+    tester.save(value_type(Integer(1),Matrix<int>(1,1,1)),2);
+    tester.save(value_type(Integer(2),Matrix<int>(1,1,2)),1);
+    tester.save(value_type(Integer(3),Matrix<int>(1,1,3)));
+    // class 0 goes first, however recent
+    tester.save(value_type(Integer(4),Matrix<int>(1,1,4)));
+    assert(!cached(tester,3));
+    tester.save(value_type(Integer(5),Matrix<int>(1,1,5)),1);
+    assert(!cached(tester,4));
+    // then the least recently used of class 1
+    tester.save(value_type(Integer(6),Matrix<int>(1,1,6)),1);
+    assert(!cached(tester,2)&&cached(tester,5)&&cached(tester,6));
+    tester.save(value_type(Integer(7),Matrix<int>(1,1,7)),1);
+    assert(!cached(tester,5)&&cached(tester,1));
+    // an update keeps the class unless one is given
+    tester.save(value_type(Integer(1),Matrix<int>(1,1,-1)));
+    assert(tester.set_priority(Integer(6),0));
+    tester.save(value_type(Integer(8),Matrix<int>(1,1,8)),3);
+    assert(!cached(tester,6)&&cached(tester,7));
+    assert((*tester.get(Integer(1)))[0][0]==-1);
+    assert(!tester.set_priority(Integer(42),1));
+    std::cout<<c[0]<<std::endl;
+}
+
+void pin_tester(){
+    std::cout<<c[3];
+    sjtu::lru tester(10);
+    for(int i=0;i<10;i++){
+        tester.save(value_type(Integer(i),Matrix<int>(1,1,i)));
+    }
+    assert(tester.pin(Integer(0))&&tester.pin(Integer(1)));
+    assert(tester.pin(Integer(0)));
+    assert(!tester.pin(Integer(99)));
+    for(int i=10;i<100;i++){
+        tester.save(value_type(Integer(i),Matrix<int>(1,1,i)));
+    }
+    assert(cached(tester,0)&&cached(tester,1));
+    // a pinned entry stays pinned across updates and set_priority
+    tester.save(value_type(Integer(0),Matrix<int>(1,1,-5)),2);
+    assert(tester.set_priority(Integer(1),0));
+    for(int i=100;i<200;i++){
+        tester.save(value_type(Integer(i),Matrix<int>(1,1,i)));
+    }
+    assert((*tester.get(Integer(0)))[0][0]==-5&&cached(tester,1));
+    assert(tester.unpin(Integer(0))&&!tester.unpin(Integer(0)));
+    // unpinned, 0 is now the newest of class 0 and goes after the others
+    for(int i=200;i<208;i++){
+        tester.save(value_type(Integer(i),Matrix<int>(1,1,i)));
+    }
+    assert(!cached(tester,199)&&cached(tester,0));
+    for(int i=300;i<309;i++){
+        tester.save(value_type(Integer(i),Matrix<int>(1,1,i)));
+    }
+    assert(!cached(tester,0)&&cached(tester,1));
+    assert(tester.stats().bytes==10*sjtu::value_bytes(Matrix<int>(1,1,0)));
+    std::cout<<c[0]<<std::endl;
+}
+
+void limit_tester(){
+    std::cout<<c[4];
+    sjtu::lru tester(10);
+    for(int i=0;i<10;i++){
+        tester.save(value_type(Integer(i),Matrix<int>(1,1,i)));
+    }
+    // half the capacity by default
+    for(int i=0;i<5;i++){
+        assert(tester.pin(Integer(i)));
+    }
+    assert(!tester.pin(Integer(5)));
+    tester.set_pin_limit(9);
+    for(int i=5;i<9;i++){
+        assert(tester.pin(Integer(i)));
+    }
+    // one entry always stays evictable
+    assert(!tester.pin(Integer(9)));
+    tester.save(value_type(Integer(10),Matrix<int>(1,1,10)));
+    assert(!cached(tester,9)&&cached(tester,10));
+    for(int i=0;i<9;i++){
+        assert(cached(tester,i));
+    }
+    std::cout<<c[0]<<std::endl;
+}
+
+int main(){
+    priority_tester();
+    pin_tester();
+    limit_tester();
+    std::cout << c[7] << std::endl;
+}
@@ -0,0 +1,173 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: front cache invalidation",
+    "test2: front hits keep keys hot",
+    "test3: front hits in stats",
+    "test4: front cache under threads",
+    "test5: idle threads keep no evicted values",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+using value_type = sjtu::pair<Integer,Matrix<int> >;
+
+void invalidation_tester(){
+    std::cout<<c[2];
+    sjtu::lru a(100),b(100);
+    a.enable_front_cache();
+    b.enable_front_cache();
+    for(int i=0;i<100;i++){
+        a.save(value_type(Integer(i),Matrix<int>(2,2,i)));
+        b.save(value_type(Integer(i),Matrix<int>(2,2,-i)));
+    }
+    // two caches never share a slot's value
+    assert((*a.get(Integer(5)))[0][0]==5&&(*a.get(Integer(5)))[0][0]==5);
+    assert((*b.get(Integer(5)))[0][0]==-5&&(*a.get(Integer(5)))[0][0]==5);
+    a.save(value_type(Integer(5),Matrix<int>(2,2,55)));
+    assert((*a.get(Integer(5)))[0][0]==55);
+    a.clear();
+    assert(a.get(Integer(5))==nullptr);
+    a.save(value_type(Integer(5),Matrix<int>(2,2,7)));
+    a.get(Integer(5));
+    a.disable_front_cache();
+    a.save(value_type(Integer(5),Matrix<int>(2,2,8)));
+    a.enable_front_cache();
+    assert((*a.get(Integer(5)))[0][0]==8);
+    std::cout<<c[0]<<std::endl;
+}
+
+void recency_tester(){
+    std::cout<<c[3];
+    sjtu::lru tester(3);
+    tester.enable_front_cache();
+    for(int i=1;i<=3;i++){
+        tester.save(value_type(Integer(i),Matrix<int>(2,2,i)));
+    }
+    // the first get of each key fills its front slot
+    for(int i=1;i<=3;i++){
+        tester.get(Integer(i));
+    }
+    // 1 is the least recently used entry until its front hits are replayed
+    for(int i=0;i<100;i++){
+        assert((*tester.get(Integer(1)))[1][1]==1);
+    }
+    tester.save(value_type(Integer(4),Matrix<int>(2,2,4)));
+    assert(tester.get(Integer(1))!=nullptr);
+    assert(tester.get(Integer(2))==nullptr);
+    // the same through get_handle, for an entry of a priority class
+    tester.save(value_type(Integer(5),Matrix<int>(2,2,5)),1);
+    tester.save(value_type(Integer(6),Matrix<int>(2,2,6)),1);
+    tester.save(value_type(Integer(7),Matrix<int>(2,2,7)),1);
+    tester.get_handle(Integer(5));
+    tester.get_handle(Integer(6));
+    tester.get_handle(Integer(7));
+    for(int i=0;i<100;i++){
+        assert(tester.get_handle(Integer(5)));
+    }
+    tester.save(value_type(Integer(8),Matrix<int>(2,2,8)),1);
+    assert(tester.get(Integer(5))!=nullptr);
+    assert(tester.get(Integer(6))==nullptr);
+    std::cout<<c[0]<<std::endl;
+}
+
+void stats_tester(){
+    std::cout<<c[4];
+    sjtu::lru tester(10);
+    tester.enable_front_cache();
+    tester.save(value_type(Integer(1),Matrix<int>(2,2,1)));
+    for(int i=0;i<50;i++){
+        tester.get(Integer(1));
+    }
+    for(int i=0;i<50;i++){
+        tester.get_handle(Integer(1));
+    }
+    assert(tester.stats().hits==100);
+    // with the mrc on every get is sampled
+    tester.enable_mrc(1.0,64,16,4);
+    for(int i=0;i<50;i++){
+        tester.get(Integer(1));
+    }
+    assert(tester.hit_ratio_curve().back().second>0.9);
+    assert(tester.stats().hits==150);
+    std::cout<<c[0]<<std::endl;
+}
+
+void threads_tester(){
+    std::cout<<c[5];
+    sjtu::lru tester(100);
+    tester.enable_front_cache();
+    for(int i=0;i<100;i++){
+        tester.save(value_type(Integer(i),Matrix<int>(2,2,0)));
+    }
+    std::atomic<bool> stop(false);
+    std::atomic<int> bad(0);
+    std::vector<std::thread> th;
+    for(int t=0;t<3;t++){
+        th.emplace_back([&](){
+            while(!stop){
+                for(int k=0;k<8;k++){
+                    sjtu::lru::handle m=tester.get_handle(Integer(k));
+                    if(!m||(*m)[0][0]!=(*m)[1][1])
+                        bad++;
+                }
+            }
+        });
+    }
+    for(int r=1;r<2000;r++){
+        tester.save(value_type(Integer(r%8),Matrix<int>(2,2,r)));
+    }
+    stop=true;
+    for(auto &x:th)x.join();
+    assert(bad==0);
+    // once the writer is done everyone sees the last values
+    for(int k=0;k<8;k++){
+        int last=1999-(1999-k)%8;
+        assert((*tester.get(Integer(k)))[0][0]==last);
+    }
+    std::cout<<c[0]<<std::endl;
+}
+
+void idle_tester(){
+    std::cout<<c[6];
+    sjtu::lru cache(4);
+    cache.enable_front_cache();
+    cache.save(value_type(Integer(1),Matrix<int>(64,64,1)));
+    cache.save(value_type(Integer(2),Matrix<int>(1,1,2)));
+    std::atomic<bool> filled(false),done(false);
+    // fills its front slot for 1, then reads 2 and goes idle
+    std::thread reader([&]{
+        for(int r=0;r<3;r++) assert((*cache.get(Integer(1)))[0][0]==1);
+        assert(cache.get(Integer(2))!=nullptr);
+        filled=true;
+        while(!done) std::this_thread::yield();
+    });
+    while(!filled) std::this_thread::yield();
+    sjtu::lru::handle h=cache.get_handle(Integer(1));
+    // the cache's node and h; the reader's slot does not count
+    assert(h.use_count()==2);
+    cache.save(value_type(Integer(1),Matrix<int>(1,1,3)));
+    assert(h.use_count()==1&&(*h)[63][63]==1);
+    done=true;
+    reader.join();
+    std::cout<<c[0]<<std::endl;
+}
+
+int main(){
+    invalidation_tester();
+    recency_tester();
+    stats_tester();
+    threads_tester();
+    idle_tester();
+    std::cout << c[7] << std::endl;
+}
@@ -0,0 +1,105 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: value_handle",
+    "test2: handles outlive eviction",
+    "test3: handles under threads",
+    "",
+    "",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+using value_type = sjtu::pair<Integer,Matrix<int> >;
+
+struct tracked {
+    static int alive;
+    int v;
+    tracked(int v):v(v){alive++;}
+    tracked(const tracked &o):v(o.v){alive++;}
+    ~tracked(){alive--;}
+};
+int tracked::alive=0;
+
+void value_handle_tester(){
+    std::cout<<c[2];
+    {
+        sjtu::value_handle<tracked> a(tracked(3));
+        assert(tracked::alive==1&&a.use_count()==1&&a->v==3);
+        sjtu::value_handle<tracked> b=a;
+        assert(a.use_count()==2&&b.get()==a.get());
+        sjtu::value_handle<tracked> m(std::move(b));
+        assert(!b&&b.get()==nullptr&&b.use_count()==0&&a.use_count()==2);
+        a.reset();
+        assert(!a&&tracked::alive==1&&(*m).v==3);
+        a=m;
+        m=sjtu::value_handle<tracked>(tracked(4));
+        assert(tracked::alive==2&&a.use_count()==1&&m->v==4);
+    }
+    assert(tracked::alive==0);
+    std::cout<<c[0]<<std::endl;
+}
+
+void eviction_tester(){
+    std::cout<<c[3];
+    sjtu::lru tester(4);
+    for(int i=0;i<4;i++){
+        tester.save(value_type(Integer(i),Matrix<int>(2,2,i)));
+    }
+    sjtu::lru::handle h=tester.get_handle(Integer(0));
+    sjtu::lru::handle u=tester.get_handle(Integer(1));
+    assert(h&&(*h)[1][1]==0&&h.use_count()==2);
+    for(int i=4;i<10;i++){
+        tester.save(value_type(Integer(i),Matrix<int>(2,2,i)));
+    }
+    // evicted, but still readable through the handle
+    assert(tester.get(Integer(0))==nullptr&&!tester.get_handle(Integer(0)));
+    assert(h.use_count()==1&&(*h)[0][0]==0);
+    // replaced and cleared values stay alive too
+    sjtu::lru::handle r=tester.get_handle(Integer(9));
+    tester.save(value_type(Integer(9),Matrix<int>(2,2,-9)));
+    assert((*r)[0][0]==9&&(*tester.get(Integer(9)))[0][0]==-9);
+    sjtu::lru::handle k=tester.get_handle(Integer(8));
+    tester.clear();
+    assert((*k)[1][1]==8&&k.use_count()==1);
+    assert((*u)[1][0]==1);
+    std::cout<<c[0]<<std::endl;
+}
+
+void threads_tester(){
+    std::cout<<c[4];
+    sjtu::lru tester(4);
+    std::vector<std::thread> th;
+    std::atomic<int> bad(0);
+    for(int t=0;t<3;t++){
+        th.emplace_back([&,t](){
+            for(int i=0;i<20000;i++){
+                sjtu::lru::handle x=tester.get_handle(Integer(i%12));
+                if(x&&(*x)[0][0]!=(*x)[1][1])
+                    bad++;
+                if(t==0)
+                    tester.save(value_type(Integer(i%12),Matrix<int>(2,2,i)));
+            }
+        });
+    }
+    for(auto &x:th)x.join();
+    assert(bad==0);
+    std::cout<<c[0]<<std::endl;
+}
+
+int main(){
+    value_handle_tester();
+    eviction_tester();
+    threads_tester();
+    std::cout << c[7] << std::endl;
+}
@@ -0,0 +1,121 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <string>
+#include <vector>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: counting_bloom has no false negatives",
+    "test2: counting_bloom false positives",
+    "test3: lru negative filter",
+    "",
+    "",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+using value_type = sjtu::pair<Integer,Matrix<int> >;
+
+void false_negative_tester(){
+    std::cout<<c[2];
+    const int K=5000;
+    sjtu::counting_bloom b(1000);
+    std::vector<int> count(K,0);
+    std::mt19937 rng(11);
+    // random adds and removes of present keys, the same key many times over
+    for(int i=0;i<200000;i++){
+        int k=rng()%K;
+        if(count[k]>0&&rng()%2){
+            b.remove(Hash()(Integer(k)));
+            count[k]--;
+        }else if(count[k]<3){
+            b.add(Hash()(Integer(k)));
+            count[k]++;
+        }
+        if(i%1000==0){
+            for(int j=0;j<K;j++){
+                if(count[j]>0)
+                    assert(b.may_contain(Hash()(Integer(j))));
+            }
+        }
+    }
+    b.clear();
+    assert(!b.may_contain(Hash()(Integer(1))));
+    std::cout<<c[0]<<std::endl;
+}
+
+void false_positive_tester(){
+    std::cout<<c[3];
+    sjtu::counting_bloom b(1000);
+    for(int i=0;i<1000;i++){
+        b.add(Hash()(Integer(i)));
+    }
+    int fp=0;
+    for(int i=1000;i<101000;i++){
+        fp+=b.may_contain(Hash()(Integer(i)));
+    }
+    assert(fp<5000);
+    // removing every key brings all counters back to zero
+    for(int i=0;i<1000;i++){
+        b.remove(Hash()(Integer(i)));
+    }
+    fp=0;
+    for(int i=0;i<1000;i++){
+        fp+=b.may_contain(Hash()(Integer(i)));
+    }
+    assert(fp==0);
+    std::cout<<c[0]<<std::endl;
+}
+
+void lru_filter_tester(){
+    std::cout<<c[4];
+    sjtu::lru plain(100),filtered(100);
+    for(int i=0;i<50;i++){
+        plain.save(value_type(Integer(i),Matrix<int>(1,1,i)));
+        filtered.save(value_type(Integer(i),Matrix<int>(1,1,i)));
+    }
+    // entries saved before the filter is enabled are in it as well
+    filtered.enable_negative_filter();
+    filtered.enable_compression(20);
+    plain.enable_compression(20);
+    std::mt19937 rng(5);
+    for(int i=0;i<20000;i++){
+        int k=rng()%400;
+        int op=rng()%8;
+        if(op==0){
+            plain.save(value_type(Integer(k),Matrix<int>(1,1,i)),1);
+            filtered.save(value_type(Integer(k),Matrix<int>(1,1,i)),1);
+        }else if(op<3){
+            plain.save(value_type(Integer(k),Matrix<int>(1,1,i)));
+            filtered.save(value_type(Integer(k),Matrix<int>(1,1,i)));
+        }else if(op==3){
+            assert(plain.pin(Integer(k))==filtered.pin(Integer(k)));
+        }else if(op==4){
+            assert(plain.unpin(Integer(k))==filtered.unpin(Integer(k)));
+        }
+        const Matrix<int> *x=plain.get(Integer(k)),*y=filtered.get(Integer(k));
+        assert((x==nullptr)==(y==nullptr));
+        if(x)
+            assert(*x==*y);
+    }
+    plain.resize(30);
+    filtered.resize(30);
+    for(int k=0;k<400;k++){
+        assert((plain.get(Integer(k))==nullptr)==(filtered.get(Integer(k))==nullptr));
+    }
+    filtered.clear();
+    assert(filtered.get(Integer(1))==nullptr);
+    std::cout<<c[0]<<std::endl;
+}
+
+int main(){
+    false_negative_tester();
+    false_positive_tester();
+    lru_filter_tester();
+    std::cout << c[7] << std::endl;
+}
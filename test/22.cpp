@@ -0,0 +1,138 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <sys/stat.h>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: resize",
+    "test2: read_memory_usage",
+    "test3: memory_watcher",
+    "test4: remove_front stats",
+    "",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+using value_type = sjtu::pair<Integer,Matrix<int> >;
+
+void put(const std::string &path,const char *text){
+    std::FILE *f=std::fopen(path.c_str(),"w");
+    std::fputs(text,f);
+    std::fclose(f);
+}
+
+void resize_tester(){
+    std::cout<<c[2];
+    for(int mode=0;mode<3;mode++){
+        sjtu::lru tester(1000);
+        if(mode==1)
+            tester.enable_compression(100);
+        if(mode==2)
+            tester.set_reclaim_mode(sjtu::reclaim_mode::manual);
+        tester.enable_negative_filter();
+        for(int i=0;i<1000;i++){
+            tester.save(value_type(Integer(i),Matrix<int>(2,2,i)),i%10==0?1:0);
+        }
+        assert(tester.pin(Integer(3)));
+        // a small cut takes the oldest of class 0, a big one reaches class 1
+        tester.resize(900);
+        assert(tester.get(Integer(3))!=nullptr&&tester.get(Integer(99))==nullptr);
+        assert(tester.get(Integer(110))!=nullptr&&tester.get(Integer(113))!=nullptr);
+        tester.resize(50);
+        int have=0;
+        for(int i=0;i<1000;i++){
+            if(tester.get(Integer(i))!=nullptr)
+                have++;
+        }
+        assert(have==50&&tester.capacity()==50);
+        assert(tester.stats().bytes==50*sjtu::value_bytes(Matrix<int>(2,2,0)));
+        for(int i=0;i<1000;i++){
+            tester.save(value_type(Integer(i),Matrix<int>(2,2,i)));
+        }
+        assert((*tester.get(Integer(999)))[1][1]==999);
+        // pinned entries stay even past the capacity
+        tester.resize(0);
+        assert(tester.get(Integer(3))!=nullptr&&tester.get(Integer(999))==nullptr);
+        tester.resize(10);
+        tester.save(value_type(Integer(5),Matrix<int>(2,2,5)));
+        assert(tester.get(Integer(5))!=nullptr);
+        tester.reclaim();
+    }
+    std::cout<<c[0]<<std::endl;
+}
+
+void usage_tester(){
+    std::cout<<c[3];
+    mkdir("22.cg",0755);
+    put("22.cg/memory.max","1000\n");
+    put("22.cg/memory.current","250\n");
+    uint64_t used=0,limit=0;
+    assert(sjtu::read_memory_usage(used,limit,"22.cg","22.missing"));
+    assert(used==250&&limit==1000);
+    // no cgroup limit: fall back to meminfo
+    put("22.cg/memory.max","max\n");
+    put("22.meminfo","MemTotal:       1000 kB\nMemFree:         100 kB\nMemAvailable:    400 kB\n");
+    assert(sjtu::read_memory_usage(used,limit,"22.cg","22.meminfo"));
+    assert(used==600*1024&&limit==1000*1024);
+    assert(!sjtu::read_memory_usage(used,limit,"22.missing","22.missing"));
+    std::cout<<c[0]<<std::endl;
+}
+
+void watcher_tester(){
+    std::cout<<c[4];
+    put("22.cg/memory.max","1000\n");
+    put("22.cg/memory.current","950\n");
+    sjtu::lru tester(100);
+    sjtu::memory_watcher w(tester,10,200);
+    w.set_sources("22.cg","22.missing");
+    // above high: shrink by a quarter; below low: grow by an eighth
+    assert(w.poll()&&tester.capacity()==75);
+    put("22.cg/memory.current","100\n");
+    assert(w.poll()&&tester.capacity()==84);
+    put("22.cg/memory.current","800\n");
+    assert(!w.poll()&&tester.capacity()==84);
+    put("22.cg/memory.current","990\n");
+    w.start(std::chrono::milliseconds(1));
+    for(int i=0;i<500&&tester.capacity()!=10;i++){
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    w.stop();
+    assert(tester.capacity()==10);
+    std::remove("22.cg/memory.max");
+    std::remove("22.cg/memory.current");
+    std::remove("22.cg");
+    std::remove("22.meminfo");
+    std::cout<<c[0]<<std::endl;
+}
+
+void remove_front_stats_tester(){
+    std::cout<<c[5];
+    sjtu::linked_hashmap<int,int> map;
+    for(int i=0;i<10;i++){
+        map.insert(sjtu::pair<const int,int>(i,i));
+    }
+    int seen=0;
+    map.remove_front(4,[&seen](int,int){seen++;});
+    map.remove_front(100,[&seen](int,int){seen++;});
+    assert(map.peek(3)==map.end());
+    sjtu::cache_stats s=map.stats();
+    assert(seen==10&&s.evictions==10&&s.bytes==0);
+    assert(s.hits==0&&s.misses==0);
+    std::cout<<c[0]<<std::endl;
+}
+
+int main(){
+    resize_tester();
+    usage_tester();
+    watcher_tester();
+    remove_front_stats_tester();
+    std::cout << c[7] << std::endl;
+}
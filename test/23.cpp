@@ -0,0 +1,173 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <csignal>
+#include <cstring>
+#include <string>
+#include <sys/file.h>
+#include <sys/wait.h>
+
+#include "shm_lru.hpp"
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: shared_lru across fork",
+    "test2: many processes",
+    "test3: owner dies holding the lock",
+    "test4: creator dies before initialising",
+    "",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+const char *name="/sjtu-lru-test23";
+
+int wait_child(pid_t pid){
+    int st;
+    waitpid(pid,&st,0);
+    return WIFEXITED(st)?WEXITSTATUS(st):-1;
+}
+
+void fork_tester(){
+    std::cout<<c[2];
+    sjtu::shared_lru::unlink(name);
+    sjtu::shared_lru a;
+    assert(a.open(name,4,64));
+    assert(a.save(Integer(1),Matrix<int>(2,2,1)));
+    assert(!a.save(Integer(9),Matrix<int>(5,5,1)));
+    pid_t pid=fork();
+    if(pid==0){
+        sjtu::shared_lru b;
+        if(!b.open(name,4,64))_exit(1);
+        Matrix<int> m;
+        if(!b.get(Integer(1),m)||m[1][1]!=1)_exit(2);
+        for(int i=2;i<=5;i++){
+            b.save(Integer(i),Matrix<int>(1,3,i));
+        }
+        _exit(0);
+    }
+    assert(wait_child(pid)==0);
+    Matrix<int> m;
+    // the child's saves evicted 1
+    assert(a.size()==4&&!a.get(Integer(1),m));
+    assert(a.get(Integer(2),m)&&m.ColSize()==3&&m[0][2]==2);
+    assert(a.remove(Integer(3))&&a.size()==3);
+    assert(a.get(Integer(4),m)&&m[0][0]==4&&a.get(Integer(5),m)&&a.get(Integer(2),m));
+    a.save(Integer(6),Matrix<int>(1,1,6));
+    a.save(Integer(7),Matrix<int>(1,1,7));
+    assert(!a.get(Integer(4),m)&&a.get(Integer(7),m)&&a.size()==4);
+    // every process must pass the same capacity and slot size
+    sjtu::shared_lru other;
+    assert(!other.open(name,8,64)&&!other.open(name,4,128));
+    std::cout<<c[0]<<std::endl;
+}
+
+void processes_tester(){
+    std::cout<<c[3];
+    pid_t pids[4];
+    for(int p=0;p<4;p++){
+        pids[p]=fork();
+        if(pids[p]==0){
+            sjtu::shared_lru b;
+            if(!b.open(name,4,64))_exit(1);
+            for(int i=0;i<2000;i++){
+                b.save(Integer(100+i%10),Matrix<int>(2,2,i%10));
+                Matrix<int> x;
+                if(b.get(Integer(100+(i*7)%10),x)&&x[1][0]!=(i*7)%10)_exit(3);
+            }
+            _exit(0);
+        }
+    }
+    for(int p=0;p<4;p++){
+        assert(wait_child(pids[p])==0);
+    }
+    sjtu::shared_lru a;
+    assert(a.open(name,4,64)&&a.size()==4);
+    std::cout<<c[0]<<std::endl;
+}
+
+void owner_dies_tester(){
+    std::cout<<c[4];
+    sjtu::shared_lru a;
+    assert(a.open(name,4,64));
+    pid_t pid=fork();
+    if(pid==0){
+        int fd=shm_open(name,O_RDWR,0600);
+        char *p=(char *)mmap(nullptr,4096,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+        // the header's mutex follows the magic, the two sizes and the slot size
+        pthread_mutex_lock((pthread_mutex_t *)(p+24));
+        _exit(0);
+    }
+    assert(wait_child(pid)==0);
+    Matrix<int> m;
+    // the links may be half updated, so the next locker empties the cache
+    assert(!a.get(Integer(7),m)&&a.size()==0);
+    a.save(Integer(7),Matrix<int>(1,1,7));
+    assert(a.get(Integer(7),m)&&m[0][0]==7&&a.size()==1);
+    sjtu::shared_lru::unlink(name);
+    std::cout<<c[0]<<std::endl;
+}
+
+void creator_dies_tester(){
+    std::cout<<c[5];
+    // killed after creating the object, before giving it a size
+    pid_t pid=fork();
+    if(pid==0){
+        int fd=shm_open(name,O_RDWR|O_CREAT|O_EXCL,0600);
+        flock(fd,LOCK_EX);
+        _exit(fd<0);
+    }
+    assert(wait_child(pid)==0);
+    sjtu::shared_lru a;
+    assert(a.open(name,4,64));
+    assert(a.save(Integer(1),Matrix<int>(1,1,1))&&a.size()==1);
+    a.close();
+    sjtu::shared_lru::unlink(name);
+    // killed after sizing the object, before the header was complete:
+    // the magic number is written last, so it is still zero
+    pid=fork();
+    if(pid==0){
+        sjtu::shared_lru b;
+        if(!b.open(name,4,64))_exit(1);
+        b.close();
+        int fd=shm_open(name,O_RDWR,0600);
+        char *p=(char *)mmap(nullptr,4096,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+        std::memset(p,0,8);
+        _exit(0);
+    }
+    assert(wait_child(pid)==0);
+    sjtu::shared_lru b;
+    assert(b.open(name,4,64));
+    Matrix<int> m;
+    assert(b.size()==0&&!b.get(Integer(1),m));
+    assert(b.save(Integer(2),Matrix<int>(1,1,2))&&b.get(Integer(2),m)&&m[0][0]==2);
+    // a holder that never lets go makes open give up instead of waiting forever
+    int fd=shm_open(name,O_RDWR,0600);
+    pid=fork();
+    if(pid==0){
+        int own=shm_open(name,O_RDWR,0600);
+        flock(own,LOCK_EX);
+        sleep(5);
+        _exit(0);
+    }
+    usleep(100000);
+    sjtu::shared_lru d;
+    assert(!d.open(name,4,64));
+    kill(pid,SIGKILL);
+    wait_child(pid);
+    assert(d.open(name,4,64)&&d.get(Integer(2),m));
+    close(fd);
+    sjtu::shared_lru::unlink(name);
+    std::cout<<c[0]<<std::endl;
+}
+
+int main(){
+    fork_tester();
+    processes_tester();
+    owner_dies_tester();
+    creator_dies_tester();
+    std::cout << c[7] << std::endl;
+}
@@ -0,0 +1,107 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: row-major contiguous layout",
+    "test2: copy, move and assign",
+    "test3: arithmetic on contiguous storage",
+    "",
+    "",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void layout_tester(){
+    std::cout<<c[2];
+    Matrix<int> m(5,7);
+    for(size_t i=0;i<5;i++){
+        for(size_t j=0;j<7;j++){
+            m[i][j]=int(i*7+j);
+        }
+    }
+    assert(m.size()==35);
+    for(int k=0;k<35;k++){
+        assert(m.data()[k]==k&&m.elem(k)==k);
+    }
+    for(size_t i=0;i<5;i++){
+        assert(m.row_data(i)==m.data()+i*7);
+    }
+    // the buffer starts on a cache line
+    Matrix<double> d(3,3,1.0);
+    assert(reinterpret_cast<uintptr_t>(d.data())%64==0);
+    assert(reinterpret_cast<uintptr_t>(m.data())%64==0);
+    Matrix<int> e;
+    assert(e.size()==0&&e.RowSize()==0&&e.ColSize()==0);
+    std::cout<<c[0]<<std::endl;
+}
+
+void ownership_tester(){
+    std::cout<<c[3];
+    Matrix<int> a(3,4,2);
+    Matrix<int> b(a);
+    b[1][1]=9;
+    assert(a[1][1]==2&&b[1][1]==9&&b.data()!=a.data());
+    const int *p=b.data();
+    Matrix<int> m(std::move(b));
+    assert(m.data()==p&&b.size()==0&&b.RowSize()==0);
+    a=m;
+    assert(a==m&&a.data()!=m.data());
+    b=std::move(m);
+    assert(b.data()==p&&m.size()==0);
+    // a smaller reshape reuses the buffer
+    b.assign(2,3,7);
+    assert(b.data()==p&&b.RowSize()==2&&b.ColSize()==3&&b[1][2]==7);
+    b.assign(1,1,0);
+    assert(b.data()==p&&b.size()==1);
+    std::cout<<c[0]<<std::endl;
+}
+
+void arithmetic_tester(){
+    std::cout<<c[4];
+    Matrix<long long> a(4,6),b(6,3);
+    for(size_t i=0;i<4;i++){
+        for(size_t j=0;j<6;j++){
+            a[i][j]=(long long)(i*6+j)-10;
+        }
+    }
+    for(size_t i=0;i<6;i++){
+        for(size_t j=0;j<3;j++){
+            b[i][j]=(long long)(i+2*j)%5-2;
+        }
+    }
+    Matrix<long long> p=a*b;
+    assert(p.RowSize()==4&&p.ColSize()==3);
+    for(size_t i=0;i<4;i++){
+        for(size_t j=0;j<3;j++){
+            long long s=0;
+            for(size_t k=0;k<6;k++){
+                s+=a[i][k]*b[k][j];
+            }
+            assert(p[i][j]==s);
+        }
+    }
+    Matrix<long long> t=Transpose(a);
+    for(size_t i=0;i<4;i++){
+        for(size_t j=0;j<6;j++){
+            assert(t[j][i]==a[i][j]);
+        }
+    }
+    Matrix<long long> s=a+a-a*2LL;
+    assert(s==Matrix<long long>(4,6,0));
+    std::cout<<c[0]<<std::endl;
+}
+
+int main(){
+    layout_tester();
+    ownership_tester();
+    arithmetic_tester();
+    std::cout << c[7] << std::endl;
+}
@@ -0,0 +1,161 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <atomic>
+#include <cassert>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: thread_pool parallel_for",
+    "test2: same products for every thread count",
+    "test3: concurrent products",
+    "test4: Pow on several threads",
+    "test5: mid-sized products split over threads",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+template<class T>
+Matrix<T> random_matrix(size_t r,size_t c,unsigned seed){
+    std::mt19937 gen(seed);
+    Matrix<T> m(r,c);
+    for(size_t i=0;i<m.size();i++){
+        m.data()[i]=T(int(gen()%21)-10);
+    }
+    return m;
+}
+
+void pool_tester(){
+    std::cout<<c[2];
+    sjtu::thread_pool pool(4);
+    assert(pool.size()==4);
+    // uneven tasks, so the workers have to steal
+    std::vector<std::atomic<int> > hits(1000);
+    pool.parallel_for(1000,[&](size_t i){
+        volatile size_t spin=0;
+        for(size_t k=0;k<(i%7==0?20000:10);k++) spin=spin+k;
+        hits[i]++;
+    });
+    for(auto &h:hits) assert(h==1);
+    // nested calls run serially inside the task
+    std::atomic<int> inner(0);
+    pool.parallel_for(8,[&](size_t){
+        pool.parallel_for(5,[&](size_t){ inner++; });
+    });
+    assert(inner==40);
+    bool thrown=false;
+    try{
+        pool.parallel_for(100,[](size_t i){ if(i==37) throw std::runtime_error("37"); });
+    }catch(std::runtime_error &e){
+        thrown=std::string(e.what())=="37";
+    }
+    assert(thrown);
+    pool.parallel_for(0,[](size_t){ assert(false); });
+    std::cout<<c[0]<<std::endl;
+}
+
+void threads_tester(){
+    std::cout<<c[3];
+    assert(sjtu::gemm_parallel().threads==1);
+    size_t sizes[][3]={{300,1100,70},{257,300,300},{129,2100,9}};
+    for(auto &s:sizes){
+        Matrix<int> a=random_matrix<int>(s[0],s[2],1),b=random_matrix<int>(s[2],s[1],2);
+        Matrix<double> da=random_matrix<double>(s[0],s[2],3),db=random_matrix<double>(s[2],s[1],4);
+        sjtu::gemm_parallel().threads=1;
+        Matrix<int> ref=a*b;
+        Matrix<double> dref=da*db;
+        for(size_t t:{2,3,4,8}){
+            sjtu::gemm_parallel().threads=t;
+            assert(a*b==ref);
+            assert(da*db==dref);
+        }
+    }
+    sjtu::gemm_parallel().threads=1;
+    std::cout<<c[0]<<std::endl;
+}
+
+void concurrent_tester(){
+    std::cout<<c[4];
+    sjtu::gemm_parallel().threads=4;
+    Matrix<int> a=random_matrix<int>(260,1030,5),b=random_matrix<int>(1030,300,6);
+    sjtu::gemm_parallel().threads=1;
+    Matrix<int> ref=a*b;
+    sjtu::gemm_parallel().threads=4;
+    std::atomic<int> good(0);
+    std::vector<std::thread> callers;
+    for(int t=0;t<4;t++){
+        callers.emplace_back([&]{
+            for(int r=0;r<3;r++){
+                if(a*b==ref) good++;
+            }
+        });
+    }
+    // the thread count may change while products run
+    sjtu::gemm_parallel().threads=2;
+    for(auto &t:callers) t.join();
+    assert(good==12);
+    sjtu::gemm_parallel().threads=1;
+    std::cout<<c[0]<<std::endl;
+}
+
+void pow_tester(){
+    std::cout<<c[5];
+    Matrix<long long> a=random_matrix<long long>(200,200,7);
+    for(size_t i=0;i<a.size();i++) a.data()[i]%=3;
+    Matrix<long long> ref=Pow(a,5);
+    sjtu::gemm_parallel().threads=4;
+    sjtu::gemm_parallel().threshold=64*64*64;
+    assert(Pow(a,5)==ref);
+    assert(ref==a*a*a*a*a);
+    sjtu::gemm_parallel().threads=1;
+    sjtu::gemm_parallel().threshold=128*128*128;
+    std::cout<<c[0]<<std::endl;
+}
+
+size_t tiles(size_t m,size_t n,size_t threads,size_t nr){
+    size_t mb,nb;
+    sjtu::gemm_detail::tile_grid(m,n,threads,nr,mb,nb);
+    assert(mb%sjtu::gemm_detail::MR==0&&nb%nr==0);
+    return ((m+mb-1)/mb)*((n+nb-1)/nb);
+}
+
+void grid_tester(){
+    std::cout<<c[6];
+    // one MC x NC block, still cut into several tiles per thread
+    assert(tiles(128,256,4,8)>=16);
+    assert(tiles(100,1000,8,16)>=32);
+    // large products keep the full blocks, thin ones stop splitting
+    assert(tiles(4096,4096,4,8)==32*4);
+    assert(tiles(4,8,8,8)==1);
+    size_t sizes[][3]={{128,256,256},{130,250,200},{64,1000,128}};
+    for(auto &s:sizes){
+        Matrix<int> a=random_matrix<int>(s[0],s[2],8),b=random_matrix<int>(s[2],s[1],9);
+        Matrix<double> da=random_matrix<double>(s[0],s[2],10),db=random_matrix<double>(s[2],s[1],11);
+        sjtu::gemm_parallel().threads=1;
+        Matrix<int> ref=a*b;
+        Matrix<double> dref=da*db;
+        for(size_t t:{2,4}){
+            sjtu::gemm_parallel().threads=t;
+            assert(a*b==ref);
+            assert(da*db==dref);
+        }
+    }
+    sjtu::gemm_parallel().threads=1;
+    std::cout<<c[0]<<std::endl;
+}
+
+int main(){
+    pool_tester();
+    threads_tester();
+    concurrent_tester();
+    pow_tester();
+    grid_tester();
+    std::cout << c[7] << std::endl;
+}
@@ -0,0 +1,159 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: element-wise expressions",
+    "test2: one pass, no temporaries",
+    "test3: expressions as operands",
+    "test4: caching an expression",
+    "test5: scalars never narrow",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+// counts the arithmetic done on it
+struct Counted{
+    static int ops;
+    int v=0;
+    Counted()=default;
+    Counted(int _v):v(_v){}
+    Counted operator+(const Counted &o)const{ ops++; return Counted(v+o.v); }
+    Counted operator-(const Counted &o)const{ ops++; return Counted(v-o.v); }
+    Counted operator*(const Counted &o)const{ ops++; return Counted(v*o.v); }
+    Counted operator-()const{ ops++; return Counted(-v); }
+    Counted &operator+=(const Counted &o){ ops++; v+=o.v; return *this; }
+    bool operator==(const Counted &o)const{ return v==o.v; }
+    bool operator!=(const Counted &o)const{ return v!=o.v; }
+};
+int Counted::ops=0;
+
+void elementwise_tester(){
+    std::cout<<c[2];
+    Matrix<int> a(2,3,1),b(2,3,2),d(2,3,3);
+    Matrix<int> e=a+b-d*2;
+    assert(e==Matrix<int>(2,3,-3));
+    assert(a+b==d&&-(a-b)==a&&a*3==d&&3*a==d&&d/3.0==a);
+    e=e+a;
+    assert(e==Matrix<int>(2,3,-2));
+    e+=a+a;
+    assert(e==Matrix<int>(2,3,0));
+    e-=b;
+    assert(e==Matrix<int>(2,3,-2));
+    e*=3;
+    assert(e==Matrix<int>(2,3,-6));
+    // a different shape reshapes the target
+    Matrix<int> f(5,5,0);
+    f=a+b;
+    assert(f==d&&f.RowSize()==2&&f.ColSize()==3);
+    Matrix<double> x(2,2,1.5);
+    Matrix<double> y=x*2.0+x/2;
+    assert(y==Matrix<double>(2,2,3.75));
+    bool thrown=false;
+    try{
+        Matrix<int> g=a+Matrix<int>(3,2,0);
+    }catch(std::invalid_argument &){
+        thrown=true;
+    }
+    assert(thrown);
+    std::cout<<c[0]<<std::endl;
+}
+
+void lazy_tester(){
+    std::cout<<c[3];
+    Matrix<Counted> a(4,5,Counted(1)),b(4,5,Counted(2)),d(4,5,Counted(3));
+    Counted::ops=0;
+    Matrix<Counted> e=a+b-d*Counted(2);
+    // three operations per element, nothing more
+    assert(Counted::ops==3*20);
+    assert(e==Matrix<Counted>(4,5,Counted(-3)));
+    Counted::ops=0;
+    e=-(e+a);
+    assert(Counted::ops==2*20);
+    assert(e==Matrix<Counted>(4,5,Counted(2)));
+    // nothing runs until the expression is assigned
+    Counted::ops=0;
+    {
+        auto lazy=a+b+d;
+        assert(Counted::ops==0);
+        assert(lazy.RowSize()==4&&lazy.ColSize()==5);
+        assert(lazy.elem(7)==Counted(6)&&Counted::ops==2);
+    }
+    std::cout<<c[0]<<std::endl;
+}
+
+void operand_tester(){
+    std::cout<<c[4];
+    Matrix<int> a(2,3),s(2,2,1);
+    for(size_t i=0;i<a.size();i++) a.data()[i]=int(i);
+    assert(Transpose(a+a)==Transpose(a*2));
+    Matrix<int> p=(s+s)*s;
+    assert(p==Matrix<int>(2,2,4));
+    size_t e=2;
+    assert(Pow(s+s,e)==Matrix<int>(2,2,8));
+    std::ostringstream o1,o2;
+    o1<<(a+a);
+    o2<<Matrix<int>(a*2);
+    assert(o1.str()==o2.str());
+    std::cout<<c[0]<<std::endl;
+}
+
+void cache_tester(){
+    std::cout<<c[5];
+    sjtu::lru cache(4);
+    Matrix<int> a(2,3,1),b(2,3,2);
+    cache.save(sjtu::pair<const Integer,Matrix<int> >(Integer(1),a+b));
+    assert(*cache.get(Integer(1))==Matrix<int>(2,3,3));
+    std::cout<<c[0]<<std::endl;
+}
+
+template<class A,class B,class=void>
+struct can_mul:std::false_type{};
+template<class A,class B>
+struct can_mul<A,B,std::void_t<decltype(std::declval<A>()*std::declval<B>())> >:std::true_type{};
+template<class A,class B,class=void>
+struct can_scale:std::false_type{};
+template<class A,class B>
+struct can_scale<A,B,std::void_t<decltype(std::declval<A &>()*=std::declval<B>())> >:std::true_type{};
+
+static_assert(!can_mul<const Matrix<int> &,double>::value&&!can_mul<double,const Matrix<int> &>::value,"Matrix<int> * 2.5 would truncate");
+static_assert(!can_mul<const Matrix<float> &,double>::value&&!can_scale<Matrix<int>,double>::value,"no narrowing scalars");
+static_assert(!can_mul<const FixedMatrix<int,2,2> &,double>::value&&can_mul<const FixedMatrix<double,2,2> &,int>::value,"FixedMatrix scalars as well");
+static_assert(can_mul<const Matrix<int> &,int>::value&&can_mul<const Matrix<long long> &,int>::value,"exact and widening scalars");
+static_assert(can_mul<const Matrix<double> &,float>::value&&can_mul<const Matrix<double> &,int>::value&&can_scale<Matrix<long long>,short>::value,"exact and widening scalars");
+// a matrix of another element type converts only when asked to
+using DSum=decltype(std::declval<const Matrix<double> &>()+std::declval<const Matrix<double> &>());
+static_assert(!std::is_convertible<const Matrix<double> &,Matrix<int> >::value&&!std::is_convertible<DSum,Matrix<int> >::value,"no silent truncation");
+static_assert(std::is_constructible<Matrix<int>,const Matrix<double> &>::value&&std::is_constructible<Matrix<int>,DSum>::value,"explicit conversion");
+static_assert(!std::is_assignable<Matrix<int> &,const Matrix<double> &>::value&&!std::is_assignable<Matrix<int> &,DSum>::value,"no truncating assignment");
+static_assert(std::is_convertible<decltype(std::declval<const Matrix<int> &>()+std::declval<const Matrix<int> &>()),Matrix<int> >::value,"same element type stays implicit");
+
+void scalar_tester(){
+    std::cout<<c[6];
+    Matrix<long long> a(2,3,3);
+    assert(a*2==Matrix<long long>(2,3,6)&&2*(a+a)==Matrix<long long>(2,3,12));
+    a*=(short)-1;
+    assert(a==Matrix<long long>(2,3,-3));
+    Matrix<double> d(2,2,1.5);
+    assert(d*2.0f==Matrix<double>(2,2,3.0)&&d*2==d+d);
+    assert(Matrix<int>(d+d)==Matrix<int>(2,2,3)&&Matrix<int>(d)==Matrix<int>(2,2,1));
+    std::cout<<c[0]<<std::endl;
+}
+
+int main(){
+    elementwise_tester();
+    lazy_tester();
+    operand_tester();
+    cache_tester();
+    scalar_tester();
+    std::cout << c[7] << std::endl;
+}
@@ -0,0 +1,156 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: FixedMatrix arithmetic",
+    "test2: mixing with Matrix",
+    "test3: FixedMatrix in a linked_hashmap",
+    "test4: FixedMatrix in an lru",
+    "",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+using F=FixedMatrix<int,2,2>;
+using fixed_lru=sjtu::basic_lru<F>;
+using value_type=sjtu::pair<Integer,F>;
+
+// usable in constant expressions, and stored inline
+constexpr F cf=F(3)*2+F(1);
+static_assert(cf.elem(3)==7,"constexpr arithmetic");
+static_assert(sizeof(F)==4*sizeof(int),"inline storage");
+static_assert(F::RowSize()==2&&F::ColSize()==2&&F::size()==4,"constant sizes");
+
+void arithmetic_tester(){
+    std::cout<<c[2];
+    F a(1),b(2);
+    assert(a+b==F(3)&&b-a==a&&-a==F(-1));
+    assert(a*3==F(3)&&3*a==F(3)&&F(4)/2.0==b);
+    a+=b;
+    a-=F(1);
+    a*=5;
+    assert(a==F(10));
+    FixedMatrix<int,2,3> r;
+    r[0][2]=5;
+    r[1][0]=7;
+    FixedMatrix<int,3,2> t=Transpose(r);
+    assert(t[2][0]==5&&t[0][1]==7&&t[1][1]==0);
+    FixedMatrix<int,2,3> p=F(1)*r;
+    assert(p[1][2]==5&&p[0][0]==7&&p[0][1]==0);
+    F g=F::generate([](size_t i){ return int(i*i); });
+    assert(g[1][1]==9&&g.data()[2]==4);
+    FixedMatrix<double,2,2> d(1.5);
+    assert((d*2)[1][1]==3.0);
+    std::cout<<c[0]<<std::endl;
+}
+
+void mixed_tester(){
+    std::cout<<c[3];
+    F a(1);
+    Matrix<int> m=a+Matrix<int>(2,2,4);
+    assert(m==Matrix<int>(2,2,5));
+    Matrix<int> m2=a;
+    assert(m2==Matrix<int>(2,2,1));
+    F back(m*2);
+    assert(back==F(10));
+    bool thrown=false;
+    try{
+        F bad(Matrix<int>(3,2));
+    }catch(std::invalid_argument &){
+        thrown=true;
+    }
+    assert(thrown);
+    std::ostringstream o1,o2;
+    o1<<a;
+    o2<<Matrix<int>(2,2,1);
+    assert(o1.str()==o2.str());
+    assert(Fingerprint(F(3))==Fingerprint(F(3))&&Fingerprint(F(3))!=Fingerprint(F(4)));
+    // a FixedMatrix operand never overlaps a Matrix, so m is updated in place
+    const int *before=m.data();
+    m=m+a;
+    assert(m==Matrix<int>(2,2,6)&&m.data()==before);
+    std::cout<<c[0]<<std::endl;
+}
+
+void map_tester(){
+    std::cout<<c[4];
+    sjtu::linked_hashmap<Integer,F,Hash,Equal> map;
+    for(int i=0;i<100;i++){
+        map.insert(sjtu::pair<const Integer,F>(Integer(i),F(i)));
+    }
+    assert(map.at(Integer(42))==F(42));
+    assert(map.stats().bytes==100*sizeof(F));
+    std::cout<<c[0]<<std::endl;
+}
+
+void lru_tester(){
+    std::cout<<c[5];
+    fixed_lru cache(3);
+    for(int i=0;i<5;i++){
+        cache.save(value_type(Integer(i),F(i)));
+    }
+    assert(cache.get(Integer(0))==nullptr&&cache.get(Integer(1))==nullptr);
+    assert(*cache.get(Integer(2))==F(2));
+    // 2 is now the newest, so 3 goes next
+    cache.save(value_type(Integer(5),F(5)));
+    assert(cache.get(Integer(3))==nullptr&&*cache.get(Integer(4))==F(4));
+    cache.save(value_type(Integer(4),F(40)));
+    assert(*cache.get(Integer(4))==F(40));
+    sjtu::cache_stats s=cache.stats();
+    assert(s.inserts==6&&s.evictions==3&&s.updates==1&&s.bytes==3*sizeof(F));
+
+    F v=cache.get_or_compute(Integer(7),[](const Integer &k){ return F(k.val*2); });
+    assert(v==F(14)&&*cache.get(Integer(7))==F(14));
+    fixed_lru::handle h=cache.get_handle(Integer(7));
+    cache.clear();
+    assert(cache.get(Integer(7))==nullptr&&*h==F(14));
+
+    // equal values share one copy
+    fixed_lru shared(10);
+    shared.enable_interning();
+    for(int i=0;i<10;i++){
+        shared.save(value_type(Integer(i),F(i%2)));
+    }
+    assert(shared.interned()==2);
+    assert(shared.get_handle(Integer(0)).get()==shared.get_handle(Integer(8)).get());
+
+    fixed_lru front(4);
+    front.enable_front_cache();
+    front.save(value_type(Integer(1),F(1)));
+    for(int r=0;r<50;r++){
+        assert(*front.get(Integer(1))==F(1));
+    }
+    front.save(value_type(Integer(1),F(2)));
+    assert(*front.get(Integer(1))==F(2));
+    assert(front.stats().hits==51);
+
+    // values stay in the nodes: get points into the cache and writes stick,
+    // and a box is only made once a handle asks for one
+    fixed_lru in(4);
+    in.save(value_type(Integer(1),F(1)));
+    F *p=in.get(Integer(1));
+    (*p)[1][1]=9;
+    assert(in.get(Integer(1))==p&&(*in.get(Integer(1)))[1][1]==9);
+    fixed_lru::handle boxed=in.get_handle(Integer(1));
+    assert(boxed.use_count()==2&&(*boxed)[1][1]==9);
+    assert(in.get(Integer(1))==boxed.get()&&in.get(Integer(1))!=p);
+    in.save(value_type(Integer(1),F(3)));
+    assert(*in.get(Integer(1))==F(3)&&(*boxed)[1][1]==9);
+    std::cout<<c[0]<<std::endl;
+}
+
+int main(){
+    arithmetic_tester();
+    mixed_tester();
+    map_tester();
+    lru_tester();
+    std::cout << c[7] << std::endl;
+}
@@ -0,0 +1,146 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: blocks, transposes and rows",
+    "test2: writing through views",
+    "test3: products of views",
+    "test4: overlapping source and destination",
+    "",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+Matrix<int> numbered(size_t r,size_t c){
+    Matrix<int> m(r,c);
+    for(size_t i=0;i<r;i++){
+        for(size_t j=0;j<c;j++){
+            m[i][j]=int(i*10+j);
+        }
+    }
+    return m;
+}
+
+void window_tester(){
+    std::cout<<c[2];
+    Matrix<int> m=numbered(4,5);
+    MatrixView<int> b=m.block(1,2,2,3);
+    assert(b.RowSize()==2&&b.ColSize()==3&&b[0][0]==12&&b[1][2]==24);
+    MatrixView<int> t=m.transposed();
+    assert(t.RowSize()==5&&t[4][3]==34&&Matrix<int>(t)==Transpose(m));
+    assert(t.block(1,0,2,2)[1][1]==12);
+    MatrixView<int> r=m.row(2);
+    assert(r.RowSize()==1&&r[0][4]==24);
+    const Matrix<int> &cm=m;
+    ConstMatrixView<int> cb=cm.block(0,0,2,2);
+    assert(Matrix<int>(cb+cb)[1][1]==22);
+    bool thrown=false;
+    try{
+        m.block(3,0,2,1);
+    }catch(std::out_of_range &){
+        thrown=true;
+    }
+    assert(thrown);
+    std::ostringstream o1,o2;
+    o1<<m.view();
+    o2<<m;
+    assert(o1.str()==o2.str());
+    assert(-m.view()==-m&&2*m.view()==m*2);
+    std::cout<<c[0]<<std::endl;
+}
+
+void write_tester(){
+    std::cout<<c[3];
+    Matrix<int> m=numbered(4,5);
+    MatrixView<int> b=m.block(1,2,2,3);
+    b*=2;
+    assert(m[1][2]==24&&m[2][4]==48&&m[0][0]==0);
+    b=Matrix<int>(2,3,7);
+    assert(m[2][3]==7&&m[1][1]==11);
+    b+=Matrix<int>(2,3,1);
+    assert(m[1][2]==8);
+    // rows 0 and 3 do not overlap
+    m.block(0,0,1,5)=m.row(3);
+    assert(m[0][4]==34&&m[3][4]==34);
+    bool thrown=false;
+    try{
+        b=Matrix<int>(3,2,0);
+    }catch(std::invalid_argument &){
+        thrown=true;
+    }
+    assert(thrown);
+    std::cout<<c[0]<<std::endl;
+}
+
+void product_tester(){
+    std::cout<<c[4];
+    Matrix<double> A(64,48),B(48,40);
+    for(size_t i=0;i<A.size();i++) A.data()[i]=double(i*7%13)-6;
+    for(size_t i=0;i<B.size();i++) B.data()[i]=double(i*5%11)-5;
+    Matrix<double> ref=A*B;
+    assert(A.view()*B.view()==ref);
+    Matrix<double> D=A.block(8,4,16,20)*B.block(4,10,20,12);
+    assert(D==Matrix<double>(A.block(8,4,16,20))*Matrix<double>(B.block(4,10,20,12)));
+    Matrix<double> At=Transpose(A);
+    assert(At.transposed()*B==ref);
+    assert((A.view()+A.view())*B==ref*2.0);
+    Matrix<int> m=numbered(3,3);
+    bool thrown=false;
+    try{
+        Matrix<int> x=m.row(0)*m.row(0);
+    }catch(std::invalid_argument &){
+        thrown=true;
+    }
+    assert(thrown);
+    std::cout<<c[0]<<std::endl;
+}
+
+void overlap_tester(){
+    std::cout<<c[5];
+    // a matrix assigned an expression reading its own transpose
+    Matrix<int> a=numbered(3,3),z(3,3,100);
+    Matrix<int> expect=Transpose(a)+z;
+    a=a.transposed()+z;
+    assert(a==expect);
+    // a view assigned its own matrix's transpose
+    Matrix<int> b=numbered(4,4);
+    Matrix<int> bt=Transpose(b);
+    b.view()=b.transposed();
+    assert(b==bt);
+    // overlapping blocks shifted by one column
+    Matrix<int> s=numbered(2,5);
+    s.block(0,1,2,4)=s.block(0,0,2,4);
+    assert(s[0][1]==0&&s[0][4]==3&&s[1][4]==13&&s[1][0]==10);
+    s=numbered(2,5);
+    s.block(0,0,2,4)=s.block(0,1,2,4)+s.block(0,0,2,4);
+    assert(s[0][0]==1&&s[0][3]==7&&s[1][3]==27&&s[1][4]==14);
+    // a transposed view assigned from the matrix it views
+    Matrix<int> q=numbered(3,3);
+    Matrix<int> qt=Transpose(q);
+    q.transposed()=q*2;
+    assert(q==qt*2);
+    // same layout is still done in place
+    Matrix<int> p=numbered(3,4);
+    const int *before=p.data();
+    p=p+p*2-p.view();
+    assert(p==numbered(3,4)*2&&p.data()==before);
+    p.view()+=p.view();
+    assert(p==numbered(3,4)*4&&p.data()==before);
+    std::cout<<c[0]<<std::endl;
+}
+
+int main(){
+    window_tester();
+    write_tester();
+    product_tester();
+    overlap_tester();
+    std::cout << c[7] << std::endl;
+}
@@ -0,0 +1,200 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: sparse against dense results",
+    "test2: building and reading",
+    "test3: SparseMatrix in a linked_hashmap",
+    "test4: SparseMatrix in an lru",
+    "test5: printing and narrow indices",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+using S=SparseMatrix<int>;
+using sparse_lru=sjtu::basic_lru<S>;
+using value_type=sjtu::pair<Integer,S>;
+
+std::mt19937 rng(30);
+
+// about pct percent non-zeros
+Matrix<int> random_dense(size_t r,size_t c,int pct){
+    Matrix<int> m(r,c,0);
+    for(size_t i=0;i<m.size();i++){
+        if((int)(rng()%100)<pct) m.data()[i]=int(rng()%7)-3;
+    }
+    return m;
+}
+
+void product_tester(){
+    std::cout<<c[2];
+    for(int it=0;it<30;it++){
+        size_t m=1+rng()%40,k=1+rng()%40,n=1+rng()%40;
+        Matrix<int> A=random_dense(m,k,it%10*5),B=random_dense(k,n,15),C=random_dense(m,k,5);
+        S a(A),b(B),d(C);
+        assert(a.to_dense()==A&&S(a.to_dense())==a);
+        assert(a*B==A*B&&A*b==A*B&&(a*b).to_dense()==A*B);
+        assert((a+d).to_dense()==A+C&&(a-d).to_dense()==A-C&&(a-a).nnz()==0);
+        assert(Transpose(a).to_dense()==Transpose(A));
+        assert((3*a).to_dense()==A*3&&(a*0).nnz()==0);
+    }
+    // empty and all-zero shapes
+    S e(0,5),z(4,5);
+    assert(e.to_dense().RowSize()==0&&z.nnz()==0&&(z*Matrix<int>(5,2,1))==Matrix<int>(4,2,0));
+    std::cout<<c[0]<<std::endl;
+}
+
+void build_tester(){
+    std::cout<<c[3];
+    Matrix<int> big(200,200,0);
+    for(int i=0;i<200;i++) big[i][i]=i+1;
+    S s(big);
+    assert(s.nnz()==200&&s.at(7,7)==8&&s.at(7,8)==0);
+    assert(sjtu::value_bytes(s)<sjtu::value_bytes(big)/10);
+    S v(big.block(0,0,3,3));
+    assert(v.nnz()==3&&v.at(2,2)==3);
+    S rows(0,4);
+    size_t cols[]={0,2,3};
+    int vals[]={5,0,-1};
+    rows.push_row(cols,vals,3);
+    rows.push_row(cols,vals,0);
+    assert(rows.RowSize()==2&&rows.nnz()==2&&rows.at(0,3)==-1&&rows.at(0,2)==0);
+    bool thrown=false;
+    try{
+        s.at(200,0);
+    }catch(std::out_of_range &){
+        thrown=true;
+    }
+    assert(thrown);
+    thrown=false;
+    try{
+        s+v;
+    }catch(std::invalid_argument &){
+        thrown=true;
+    }
+    assert(thrown);
+    thrown=false;
+    try{
+        size_t bad[]={2,1};
+        rows.push_row(bad,vals,2);
+    }catch(std::invalid_argument &){
+        thrown=true;
+    }
+    assert(thrown);
+    std::cout<<c[0]<<std::endl;
+}
+
+void map_tester(){
+    std::cout<<c[4];
+    Matrix<int> eye(50,50,0);
+    for(int i=0;i<50;i++) eye[i][i]=1;
+    S id(eye);
+    sjtu::linked_hashmap<Integer,S,Hash,Equal> map;
+    for(int i=0;i<4;i++){
+        map.insert(sjtu::pair<const Integer,S>(Integer(i),id*(i+1)));
+    }
+    assert(map.at(Integer(3)).at(9,9)==4&&map.at(Integer(3)).nnz()==50);
+    // the product of a stored sparse value with a dense one
+    Matrix<int> x(50,2,1);
+    assert(map.at(Integer(2))*x==Matrix<int>(50,2,3));
+    // charged by the non-zeros, not by the dense shape
+    assert(map.stats().bytes==4*id.footprint());
+    assert(id.footprint()<eye.RowSize()*eye.ColSize()*sizeof(int));
+    std::cout<<c[0]<<std::endl;
+}
+
+void lru_tester(){
+    std::cout<<c[5];
+    sparse_lru cache(3);
+    Matrix<int> eye(50,50,0);
+    for(int i=0;i<50;i++) eye[i][i]=1;
+    S id(eye);
+    for(int i=0;i<4;i++){
+        cache.save(value_type(Integer(i),id*(i+1)));
+    }
+    assert(cache.get(Integer(0))==nullptr);
+    assert(cache.get(Integer(3))->at(9,9)==4&&cache.get(Integer(3))->nnz()==50);
+    // the product of a cached sparse value with a dense one
+    Matrix<int> x(50,2,1);
+    assert(*cache.get(Integer(2))*x==Matrix<int>(50,2,3));
+    sjtu::cache_stats st=cache.stats();
+    assert(st.inserts==4&&st.evictions==1&&st.bytes==3*(id*1).footprint());
+    S sq=cache.get_or_compute(Integer(9),[&](const Integer &){ return id*id; });
+    assert(sq==id&&*cache.get(Integer(9))==id);
+
+    sparse_lru shared(8);
+    shared.enable_interning();
+    for(int i=0;i<8;i++){
+        shared.save(value_type(Integer(i),i%2?id:S(eye*2)));
+    }
+    assert(shared.interned()==2);
+    assert(shared.get_handle(Integer(1)).get()==shared.get_handle(Integer(7)).get());
+    assert(Fingerprint(id)==Fingerprint(S(eye))&&Fingerprint(id)!=Fingerprint(S(eye*2)));
+    std::cout<<c[0]<<std::endl;
+}
+
+static_assert(std::is_same<S::value_type,int>::value&&sizeof(S().col_indices()[0])==4,"uint32_t column indices");
+template<class A,class B,class=void>
+struct can_mul:std::false_type{};
+template<class A,class B>
+struct can_mul<A,B,std::void_t<decltype(std::declval<A>()*std::declval<B>())> >:std::true_type{};
+static_assert(!can_mul<const S &,double>::value&&!can_mul<double,const S &>::value&&can_mul<const S &,short>::value,"scalars never narrow");
+
+// what print() writes to std::cout
+template<class L>
+std::string printed(L &cache){
+    std::ostringstream out;
+    std::streambuf *old=std::cout.rdbuf(out.rdbuf());
+    cache.print();
+    std::cout.rdbuf(old);
+    return out.str();
+}
+
+void print_tester(){
+    std::cout<<c[6];
+    sparse_lru cache(4);
+    sjtu::lru dense(4);
+    for(int i=0;i<4;i++){
+        Matrix<int> m=random_dense(3+i,5,30);
+        cache.save(value_type(Integer(i),S(m)));
+        dense.save(sjtu::pair<Integer,Matrix<int> >(Integer(i),m));
+    }
+    assert(printed(cache)==printed(dense));
+    std::ostringstream a,b;
+    Matrix<int> m=random_dense(6,9,20);
+    a<<S(m);
+    b<<m;
+    assert(a.str()==b.str());
+    // a row of 2^32 columns would not fit the indices
+    bool thrown=false;
+    try{
+        S wide(1,size_t(UINT32_MAX)+1);
+    }catch(std::length_error &){
+        thrown=true;
+    }
+    assert(thrown);
+    S edge(2,size_t(UINT32_MAX));
+    assert(edge.at(1,UINT32_MAX-1)==0&&edge.footprint()<1024);
+    std::cout<<c[0]<<std::endl;
+}
+
+int main(){
+    product_tester();
+    build_tester();
+    map_tester();
+    lru_tester();
+    print_tester();
+    std::cout << c[7] << std::endl;
+}
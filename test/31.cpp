@@ -0,0 +1,122 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: Pow against repeated products",
+    "test2: PowWorkspace",
+    "test3: cached squares",
+    "test4: Fingerprint",
+    "",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+template<class T>
+Matrix<T> naive(const Matrix<T> &A,size_t b){
+    Matrix<T> r=I<T>(A.RowSize());
+    while(b--) r=r*A;
+    return r;
+}
+
+Matrix<long long> small(long long shift){
+    Matrix<long long> A(3,3);
+    for(size_t i=0;i<9;i++) A.data()[i]=(long long)(i*5%7)-3+shift;
+    return A;
+}
+
+void pow_tester(){
+    std::cout<<c[2];
+    Matrix<long long> A=small(0);
+    for(size_t b=0;b<40;b++){
+        size_t e=b;
+        assert(Pow(A,e)==naive(A,b)&&e==b);
+    }
+    assert(Pow(A,0)==I<long long>(3));
+    Matrix<int> m(2,2,1);
+    assert(Pow(m+m,5)==Matrix<int>(2,2,512));
+    // large enough for the blocked kernel
+    Matrix<int> big(70,70,0);
+    for(size_t i=0;i<big.size();i++) big.data()[i]=int(i%3)-1;
+    assert(Pow(big,3)==big*big*big);
+    bool thrown=false;
+    try{
+        Pow(Matrix<int>(2,3,1),2);
+    }catch(std::invalid_argument &){
+        thrown=true;
+    }
+    assert(thrown);
+    std::cout<<c[0]<<std::endl;
+}
+
+void workspace_tester(){
+    std::cout<<c[3];
+    Matrix<long long> A=small(0);
+    PowWorkspace<long long> plain;
+    Matrix<long long> r;
+    for(size_t b=0;b<40;b++){
+        plain.power(A,b,r);
+        assert(r==naive(A,b));
+    }
+    assert(plain.cached_squares()==0);
+    // the result may be the base itself
+    Matrix<long long> C=A;
+    plain.power(C,7,C);
+    assert(C==naive(A,7));
+    // a different size reshapes the buffers
+    Matrix<long long> D(5,5,1);
+    plain.power(D,3,r);
+    assert(r==Matrix<long long>(5,5,25));
+    std::cout<<c[0]<<std::endl;
+}
+
+void squares_tester(){
+    std::cout<<c[4];
+    Matrix<long long> A=small(0),B=small(1);
+    PowWorkspace<long long> ws(true);
+    Matrix<long long> r;
+    for(size_t b=0;b<40;b++){
+        ws.power(A,b,r);
+        assert(r==naive(A,b));
+    }
+    // A, A^2, ..., A^32
+    assert(ws.cached_squares()==6);
+    ws.power(A,3,r);
+    assert(r==naive(A,3)&&ws.cached_squares()==6);
+    // another base starts over
+    ws.power(B,5,r);
+    assert(r==naive(B,5)&&ws.cached_squares()==3);
+    ws.power(A,6,r);
+    assert(r==naive(A,6)&&ws.cached_squares()==3);
+    ws.clear();
+    assert(ws.cached_squares()==0);
+    ws.power(A,6,A);
+    assert(A==naive(small(0),6));
+    std::cout<<c[0]<<std::endl;
+}
+
+void fingerprint_tester(){
+    std::cout<<c[5];
+    Matrix<long long> A=small(0),B=A;
+    assert(Fingerprint(A)==Fingerprint(B));
+    B[2][2]+=1;
+    assert(Fingerprint(A)!=Fingerprint(B));
+    // the shape counts, not only the elements
+    assert(Fingerprint(Matrix<int>(2,3,0))!=Fingerprint(Matrix<int>(3,2,0)));
+    assert(sjtu::hash_bytes("abcdefghijklmnopqrstuvwxyz0123456789",36)!=sjtu::hash_bytes("abcdefghijklmnopqrstuvwxyz0123456788",36));
+    std::cout<<c[0]<<std::endl;
+}
+
+int main(){
+    pow_tester();
+    workspace_tester();
+    squares_tester();
+    fingerprint_tester();
+    std::cout << c[7] << std::endl;
+}
@@ -0,0 +1,215 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <locale>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: FormatMatrix text",
+    "test2: operator<< against the setw loop",
+    "test3: ParseMatrix round trip",
+    "test4: binary round trip",
+    "test5: lru print",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+// what operator<< wrote element by element before FormatMatrix
+template<class T>
+std::string setw_loop(const Matrix<T> &mat,std::ios_base &(*manip)(std::ios_base &)=std::dec,const std::locale &loc=std::locale::classic()){
+    std::ostringstream stream;
+    stream.imbue(loc);
+    stream<<manip;
+    stream.precision(8);
+    stream.setf(std::ios::fixed|std::ios::right);
+    stream<<'\n';
+    for(size_t i=0;i<mat.RowSize();i++){
+        for(size_t j=0;j<mat.ColSize();j++){
+            stream<<std::setw(15)<<mat[i][j];
+        }
+        stream<<'\n';
+    }
+    return stream.str();
+}
+
+// groups digits in threes with ','
+struct thousands:std::numpunct<char>{
+    char do_thousands_sep() const override{ return ','; }
+    std::string do_grouping() const override{ return "\3"; }
+};
+
+template<class T>
+std::string streamed(const Matrix<T> &m){
+    std::ostringstream o;
+    o<<m;
+    return o.str();
+}
+
+void format_tester(){
+    std::cout<<c[2];
+    Matrix<int> a(2,2);
+    a[0][0]=1;a[0][1]=-20;a[1][0]=300;a[1][1]=0;
+    std::string t;
+    FormatMatrix(t,a);
+    assert(t=="\n              1            -20\n            300              0\n");
+    t.clear();
+    FormatMatrix(t,a,0);
+    assert(t=="\n1 -20\n300 0\n");
+    Matrix<double> d(1,2);
+    d[0][0]=1.5;d[0][1]=-0.125;
+    t="x";
+    FormatMatrix(t,d);
+    assert(t=="x\n     1.50000000    -0.12500000\n");
+    t.clear();
+    FormatMatrix(t,d,6,2);
+    assert(t=="\n  1.50 -0.12\n");
+    t.clear();
+    FormatMatrix(t,Matrix<int>());
+    assert(t=="\n");
+    std::cout<<c[0]<<std::endl;
+}
+
+void stream_tester(){
+    std::cout<<c[3];
+    std::mt19937_64 rng(32);
+    Matrix<int> a(7,9);
+    for(size_t i=0;i<a.size();i++) a.data()[i]=int(rng())>>(rng()%32);
+    assert(streamed(a)==setw_loop(a));
+    Matrix<long long> l(3,3);
+    for(size_t i=0;i<l.size();i++) l.data()[i]=(long long)rng();
+    assert(streamed(l)==setw_loop(l));
+    Matrix<double> d(5,6);
+    for(size_t i=0;i<d.size();i++) d.data()[i]=std::ldexp((double)(int64_t)rng(),int(rng()%80)-100);
+    d[0][0]=1e300;d[0][1]=-0.0;d[0][2]=0.5e-8;d[0][3]=1.000000005;d[0][4]=INFINITY;d[0][5]=NAN;
+    assert(streamed(d)==setw_loop(d));
+    Matrix<float> f(2,2);
+    f[0][0]=0.1f;f[0][1]=-3.3e10f;f[1][0]=1.25f;f[1][1]=7e-9f;
+    assert(streamed(f)==setw_loop(f));
+    Matrix<long double> ld(2,2,3.25L);
+    ld[1][1]=-1e-3L;
+    assert(streamed(ld)==setw_loop(ld));
+    Matrix<char> mc(1,2,'x');
+    assert(streamed(mc)==setw_loop(mc));
+    assert(streamed(Matrix<int>())==setw_loop(Matrix<int>())&&streamed(Matrix<int>(2,0))==setw_loop(Matrix<int>(2,0)));
+    // a stream with custom flags keeps them
+    std::ostringstream o;
+    o<<std::hex<<a;
+    assert(o.str()==setw_loop(a,std::hex));
+    // and so does its precision
+    std::ostringstream p;
+    p.precision(3);
+    p<<a<<std::hex<<a;
+    assert(p.precision()==3);
+    // a locale with its own number format is honoured
+    std::locale grouped(std::locale::classic(),new thousands);
+    std::ostringstream q;
+    q.imbue(grouped);
+    Matrix<int> big(1,2,1234567);
+    q<<big;
+    assert(q.str()==setw_loop(big,std::dec,grouped)&&q.str().find("1,234,567")!=std::string::npos);
+    std::cout<<c[0]<<std::endl;
+}
+
+void parse_tester(){
+    std::cout<<c[4];
+    Matrix<int> a(3,4);
+    for(size_t i=0;i<a.size();i++) a.data()[i]=int(i*37%11)-5;
+    for(int width:{15,0,3}){
+        std::string t;
+        FormatMatrix(t,a,width);
+        Matrix<int> back;
+        const char *e=ParseMatrix(t.data(),t.data()+t.size(),back);
+        assert(e==t.data()+t.size()&&back==a);
+    }
+    Matrix<double> d(2,3);
+    for(size_t i=0;i<d.size();i++) d.data()[i]=double(i)/8-0.25;
+    std::string t;
+    FormatMatrix(t,d);
+    Matrix<double> db;
+    ParseMatrix(t.data(),t.data()+t.size(),db);
+    // eighths are exact with 8 decimals
+    assert(db==d);
+    // stops at a blank line
+    t="\n1 2\n3 4\n\n5";
+    Matrix<int> b;
+    const char *e=ParseMatrix(t.data(),t.data()+t.size(),b);
+    assert(b.RowSize()==2&&b[1][0]==3&&*e=='\n');
+    bool thrown=false;
+    t="\n1 2\n3\n";
+    try{
+        ParseMatrix(t.data(),t.data()+t.size(),b);
+    }catch(std::invalid_argument &){
+        thrown=true;
+    }
+    assert(thrown);
+    thrown=false;
+    t="\n1 x\n";
+    try{
+        ParseMatrix(t.data(),t.data()+t.size(),b);
+    }catch(std::invalid_argument &){
+        thrown=true;
+    }
+    assert(thrown);
+    std::cout<<c[0]<<std::endl;
+}
+
+void binary_tester(){
+    std::cout<<c[5];
+    Matrix<double> d(5,6);
+    for(size_t i=0;i<d.size();i++) d.data()[i]=std::ldexp(double(i)+0.1,int(i)-10);
+    d[1][1]=NAN;
+    Matrix<int> a(3,7,-9);
+    std::stringstream bs;
+    WriteBinary(bs,d);
+    WriteBinary(bs,a);
+    WriteBinary(bs,Matrix<int>());
+    assert(bs.str().size()==3*16+30*8+21*4);
+    Matrix<double> d2;
+    Matrix<int> a2,e2(1,1,1);
+    assert(ReadBinary(bs,d2)&&ReadBinary(bs,a2)&&ReadBinary(bs,e2));
+    assert(d2.RowSize()==5&&std::memcmp(d2.data(),d.data(),d.size()*sizeof(double))==0);
+    assert(a2==a&&e2.size()==0);
+    // a truncated stream leaves the matrix alone
+    assert(!ReadBinary(bs,a2)&&a2==a);
+    std::stringstream cut(bs.str().substr(0,16+8*10));
+    assert(!ReadBinary(cut,d2)&&d2.RowSize()==5);
+    // so does a header no Matrix can hold, without trying to allocate it
+    uint64_t huge[2]={uint64_t(1)<<31,uint64_t(1)<<31};
+    std::stringstream hs(std::string((const char *)huge,sizeof(huge)));
+    assert(!ReadBinary(hs,a2)&&hs.fail()&&a2==a);
+    std::cout<<c[0]<<std::endl;
+}
+
+void print_tester(){
+    std::cout<<c[6]<<std::endl;
+    sjtu::lru cache(4);
+    for(int i=0;i<3;i++){
+        cache.save(sjtu::pair<const Integer,Matrix<int> >(Integer(i),Matrix<int>(2,2,i*1000-7)));
+    }
+    cache.get(Integer(0));
+    cache.print();
+    // a stream with custom flags gets the setw loop
+    std::cout<<std::showpos;
+    cache.print();
+    std::cout<<std::noshowpos;
+    std::cout<<c[0]<<std::endl;
+}
+
+int main(){
+    format_tester();
+    stream_tester();
+    parse_tester();
+    binary_tester();
+    print_tester();
+    std::cout << c[7] << std::endl;
+}
@@ -0,0 +1,123 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: interning dedupe",
+    "test2: shared values are read-only",
+    "test3: saving over a shared value",
+    "",
+    "",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+using value_type=sjtu::pair<const Integer,Matrix<int> >;
+
+// get keeps its signature, but nothing can write to a shared value:
+// get_const and handles are read-only and get refuses once interning is on
+static_assert(std::is_same<decltype(std::declval<sjtu::lru &>().get(Integer(0))),Matrix<int> *>::value,"get keeps its signature");
+static_assert(std::is_same<decltype(std::declval<sjtu::lru &>().get_const(Integer(0))),const Matrix<int> *>::value,"get_const is read-only");
+static_assert(std::is_same<decltype(*std::declval<sjtu::lru::handle &>()),const Matrix<int> &>::value,"handle is read-only");
+static_assert(std::is_same<decltype(std::declval<sjtu::lru::handle &>().get()),const Matrix<int> *>::value,"handle is read-only");
+
+void dedupe_tester(){
+    std::cout<<c[2];
+    sjtu::lru cache(20);
+    cache.enable_interning();
+    for(int i=0;i<20;i++){
+        cache.save(value_type(Integer(i),Matrix<int>(8,8,i%4)));
+    }
+    assert(cache.interned()==4);
+    for(int i=4;i<20;i++){
+        assert(cache.get_const(Integer(i))==cache.get_const(Integer(i%4)));
+    }
+    assert(cache.get_const(Integer(0))!=cache.get_const(Integer(1)));
+    // the bytes are still counted per entry
+    assert(cache.stats().bytes==20*sjtu::value_bytes(Matrix<int>(8,8,0)));
+    // equal values saved before interning was on are not shared
+    sjtu::lru late(4);
+    late.save(value_type(Integer(0),Matrix<int>(2,2,1)));
+    late.enable_interning();
+    late.save(value_type(Integer(1),Matrix<int>(2,2,1)));
+    late.save(value_type(Integer(2),Matrix<int>(2,2,1)));
+    assert(late.get_const(Integer(0))!=late.get_const(Integer(1))&&late.get_const(Integer(1))==late.get_const(Integer(2)));
+    std::cout<<c[0]<<std::endl;
+}
+
+bool get_refused(sjtu::lru &cache,int key){
+    try{
+        cache.get(Integer(key));
+    }catch(const std::logic_error &){
+        return true;
+    }
+    return false;
+}
+
+void readonly_tester(){
+    std::cout<<c[3];
+    sjtu::lru cache(8);
+    cache.enable_interning();
+    cache.enable_front_cache();
+    for(int i=0;i<8;i++){
+        cache.save(value_type(Integer(i),Matrix<int>(3,3,7)));
+    }
+    // a caller wanting to change a value works on a copy
+    Matrix<int> mine=*cache.get_const(Integer(2));
+    mine[1][1]=-1;
+    // a writable pointer would reach every key sharing the value
+    assert(get_refused(cache,2));
+    for(int i=0;i<8;i++){
+        assert(*cache.get_const(Integer(i))==Matrix<int>(3,3,7));
+    }
+    sjtu::lru::handle h=cache.get_handle(Integer(5));
+    assert(h.get()==cache.get_const(Integer(0))&&h.use_count()>=9);
+    // turning interning off gives every key its own copy back
+    cache.disable_interning();
+    assert(!get_refused(cache,2)&&cache.interned()==0);
+    (*cache.get(Integer(2)))[1][1]=-1;
+    assert((*cache.get(Integer(2)))[1][1]==-1);
+    for(int i=0;i<8;i++){
+        if(i!=2) assert(*cache.get(Integer(i))==Matrix<int>(3,3,7));
+    }
+    assert(*h==Matrix<int>(3,3,7));
+    std::cout<<c[0]<<std::endl;
+}
+
+void replace_tester(){
+    std::cout<<c[4];
+    sjtu::lru cache(6);
+    cache.enable_interning();
+    for(int i=0;i<6;i++){
+        cache.save(value_type(Integer(i),Matrix<int>(4,4,1)));
+    }
+    sjtu::lru::handle old=cache.get_handle(Integer(3));
+    // a new value for one key leaves the keys sharing the old one alone
+    cache.save(value_type(Integer(3),Matrix<int>(4,4,2)));
+    assert(*cache.get_const(Integer(3))==Matrix<int>(4,4,2));
+    for(int i=0;i<6;i++){
+        if(i!=3) assert(*cache.get_const(Integer(i))==Matrix<int>(4,4,1));
+    }
+    assert(*old==Matrix<int>(4,4,1)&&old.get()==cache.get_const(Integer(0)));
+    // and saving the old value again shares it once more
+    cache.save(value_type(Integer(3),Matrix<int>(4,4,1)));
+    assert(cache.get_const(Integer(3))==cache.get_const(Integer(5)));
+    Matrix<int> v=cache.get_or_compute(Integer(9),[](const Integer &){ return Matrix<int>(4,4,2); });
+    assert(v==Matrix<int>(4,4,2)&&cache.get_const(Integer(9))!=cache.get_const(Integer(3))&&*cache.get_const(Integer(9))==v);
+    std::cout<<c[0]<<std::endl;
+}
+
+int main(){
+    dedupe_tester();
+    readonly_tester();
+    replace_tester();
+    std::cout << c[7] << std::endl;
+}
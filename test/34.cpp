@@ -0,0 +1,86 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <string>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: keys sharing a bucket survive expand",
+    "test2: removed keys stay removed",
+    "test3: evicted lru keys stay evicted",
+    "",
+    "",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+using value_type=sjtu::pair<const Integer,Integer>;
+using mp=sjtu::hashmap<Integer,Integer,Hash,Equal>;
+
+void chain_tester(){
+    std::cout<<c[2];
+    mp map;
+    // 0, 8, 16, ... all land in bucket 0 of the initial table
+    for(int i=0;i<200;i++){
+        map.insert(value_type(Integer(i*8),Integer(i)));
+    }
+    for(int i=0;i<200;i++){
+        mp::iterator it=map.find(Integer(i*8));
+        assert(it!=map.end()&&it->second.val==i);
+    }
+    assert(map.size==200&&(int)map.data.size()==200);
+    std::cout<<c[0]<<std::endl;
+}
+
+void remove_tester(){
+    std::cout<<c[3];
+    mp map;
+    for(int i=0;i<1000;i++){
+        map.insert(value_type(Integer(i),Integer(i)));
+    }
+    for(int i=0;i<1000;i+=3){
+        assert(map.remove(Integer(i)));
+    }
+    assert(!map.remove(Integer(0)));
+    // enough new keys to expand twice more
+    for(int i=1000;i<4000;i++){
+        map.insert(value_type(Integer(i),Integer(-i)));
+    }
+    for(int i=0;i<4000;i++){
+        mp::iterator it=map.find(Integer(i));
+        if(i<1000&&i%3==0){
+            assert(it==map.end());
+        }else{
+            assert(it!=map.end()&&it->second.val==(i<1000?i:-i));
+        }
+    }
+    assert(map.size==4000-334&&(int)map.data.size()==map.size);
+    std::cout<<c[0]<<std::endl;
+}
+
+void lru_tester(){
+    std::cout<<c[4];
+    sjtu::lru cache(16);
+    for(int i=0;i<5000;i++){
+        cache.save(sjtu::pair<const Integer,Matrix<int> >(Integer(i),Matrix<int>(1,1,i)));
+    }
+    for(int i=0;i<5000;i++){
+        Matrix<int> *m=cache.get(Integer(i));
+        if(i<5000-16){
+            assert(m==nullptr);
+        }else{
+            assert(m!=nullptr&&(*m)[0][0]==i);
+        }
+    }
+    std::cout<<c[0]<<std::endl;
+}
+
+int main(){
+    chain_tester();
+    remove_tester();
+    lru_tester();
+    std::cout << c[7] << std::endl;
+}
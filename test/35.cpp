@@ -0,0 +1,77 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: Integer::counter across threads",
+    "test2: keys destroyed on another thread",
+    "",
+    "",
+    "",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void threads_tester(){
+    std::cout<<c[2];
+    int before=Integer::counter;
+    std::vector<std::thread> ts;
+    for(int t=0;t<4;t++){
+        ts.emplace_back([t](){
+            for(int i=0;i<200000;i++){
+                Integer a(i+t);
+                Integer b(a);
+                assert(b.val==i+t);
+            }
+        });
+    }
+    for(auto &t:ts) t.join();
+    assert(Integer::counter==before);
+    std::cout<<c[0]<<std::endl;
+}
+
+void handoff_tester(){
+    std::cout<<c[3];
+    int before=Integer::counter;
+    std::mutex m;
+    std::vector<std::unique_ptr<Integer> > box;
+    bool done=false;
+    // made here, freed by the consumer while more are made
+    std::thread consumer([&](){
+        for(;;){
+            std::vector<std::unique_ptr<Integer> > take;
+            {
+                std::lock_guard<std::mutex> lock(m);
+                take.swap(box);
+                if(take.empty()&&done) return;
+            }
+        }
+    });
+    for(int i=0;i<200000;i++){
+        std::unique_ptr<Integer> p(new Integer(i));
+        std::lock_guard<std::mutex> lock(m);
+        box.push_back(std::move(p));
+    }
+    {
+        std::lock_guard<std::mutex> lock(m);
+        done=true;
+    }
+    consumer.join();
+    assert(Integer::counter==before);
+    std::cout<<c[0]<<std::endl;
+}
+
+int main(){
+    threads_tester();
+    handoff_tester();
+    std::cout << c[7] << std::endl;
+}
@@ -0,0 +1,107 @@
+#include "src.hpp"
+#if defined (_UNORDERED_MAP_)  || (defined (_LIST_)) || (defined (_MAP_)) || (defined (_SET_)) || (defined (_UNORDERED_SET_))||(defined (_GLIBCXX_MAP)) || (defined (_GLIBCXX_UNORDERED_MAP))
+BOOM :)
+#endif
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+
+std::string c[]={
+    "   pass!",
+    "   error.",
+    "test1: get_or_compute hit & miss",
+    "test2: single flight",
+    "test3: loader exception",
+    "test4: save during a slow loader",
+    "",
+    "Congratulations. Your submission has passed all correctness tests. Good job! :)",
+};
+
+void get_or_compute_tester(){
+    std::cout<<c[2];
+    sjtu::lru tester(10);
+    int calls=0;
+    auto loader=[&calls](const Integer &k){ ++calls; return Matrix<int>(2,2,k.val); };
+    for(int i=0;i<20;i++){
+        Matrix<int> m=tester.get_or_compute(Integer(i%5),loader);
+        assert(m[1][1]==i%5);
+    }
+    assert(calls==5);
+    assert(tester.get(Integer(3))!=nullptr);
+    std::cout<<c[0]<<std::endl;
+}
+
+void single_flight_tester(){
+    std::cout<<c[3];
+    sjtu::lru tester(10);
+    std::atomic<int> calls(0);
+    auto loader=[&calls](const Integer &k){
+        ++calls;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        size_t b=10;
+        return Pow(Matrix<int>(2,2,k.val),b);
+    };
+    std::vector<std::thread> th;
+    std::atomic<int> ok(0);
+    for(int i=0;i<8;i++){
+        th.emplace_back([&](){
+            Matrix<int> m=tester.get_or_compute(Integer(1),loader);
+            if(m[0][0]==512)ok++;
+        });
+    }
+    for(auto &t:th)t.join();
+    assert(calls==1);
+    assert(ok==8);
+    std::cout<<c[0]<<std::endl;
+}
+
+void loader_exception_tester(){
+    std::cout<<c[4];
+    sjtu::lru tester(10);
+    bool thrown=false;
+    try{
+        tester.get_or_compute(Integer(7),[](const Integer &)->Matrix<int>{ throw std::runtime_error("fail"); });
+    }catch(const std::runtime_error &){
+        thrown=true;
+    }
+    assert(thrown);
+    assert(tester.get(Integer(7))==nullptr);
+    Matrix<int> m=tester.get_or_compute(Integer(7),[](const Integer &k){ return Matrix<int>(1,1,k.val); });
+    assert(m[0][0]==7);
+    std::cout<<c[0]<<std::endl;
+}
+
+void racing_save_tester(){
+    std::cout<<c[5];
+    sjtu::lru tester(10);
+    std::atomic<bool> started(false),saved(false);
+    // the loader only returns once the other thread's save is in
+    std::thread saver([&](){
+        while(!started) std::this_thread::yield();
+        tester.save(sjtu::pair<Integer,Matrix<int> >(Integer(1),Matrix<int>(2,2,-1)));
+        saved=true;
+    });
+    Matrix<int> m=tester.get_or_compute(Integer(1),[&](const Integer &){
+        started=true;
+        while(!saved) std::this_thread::yield();
+        return Matrix<int>(2,2,1);
+    });
+    saver.join();
+    assert(m==Matrix<int>(2,2,-1));
+    assert(*tester.get(Integer(1))==Matrix<int>(2,2,-1));
+    sjtu::cache_stats s=tester.stats();
+    assert(s.inserts==1&&s.updates==0);
+    std::cout<<c[0]<<std::endl;
+}
+
+int main(){
+    get_or_compute_tester();
+    single_flight_tester();
+    loader_exception_tester();
+    racing_save_tester();
+    std::cout << c[7] << std::endl;
+}